@@ -96,12 +96,24 @@ find $PKGDIR -name "*.so" | while read SOF ; do
 done
 
 # run the tools
+#   all tools needing to check a module run in one process (rchk, see src/rchk.cpp),
+#   so that the module is read and its analyses computed only once
 
-for T in $TOOLS ; do
-  find $PKGDIR -name "*.bc" | grep -v '\.o\.bc' | while read F ; do
-    FOUT=`echo $F | sed -e 's/\.bc$/.'$T'/g'`
+if [ ! -x $RCHK/src/rchk ] ; then
+  echo "Please set RCHK variables (scripts/config.inc) and RCHK installation - cannot find rchk." >&2
+  exit 2
+fi
+
+find $PKGDIR -name "*.bc" | grep -v '\.o\.bc' | while read F ; do
+  STEM=`echo $F | sed -e 's/\.bc$//g'`
+  STALE=
+  for T in $TOOLS ; do
+    FOUT=$STEM.$T
     if [ ! -r $FOUT ] || [ $F -nt $FOUT ] || [ $RBC -nt $FOUT ] ; then
-      $RCHK/src/$T $RBC $F >$FOUT 2>&1
+      STALE="$STALE,$T"
     fi
   done
+  if [ X"$STALE" != X ] ; then
+    $RCHK/src/rchk --tools ${STALE#,} --outputs $STEM $RBC $F
+  fi
 done
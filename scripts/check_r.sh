@@ -37,15 +37,28 @@ fi
 
 # run the tools
 
+BATCH=`mktemp`
+trap "rm -f $BATCH" EXIT
 for T in $TOOLS ; do
   if [ ! -r ./src/main/R.bin.$T ] || [ ./src/main/R.bin.bc -nt ./src/main/R.bin.$T ] ; then
     $RCHK/src/$T ./src/main/R.bin.bc >./src/main/R.bin.$T 2>&1
   fi
   
+  # all modules needing a check are checked in one run of the tool (--batch), so that
+  # the R bitcode is read and analyzed only once; fficheck does not support that
+  
+  : >$BATCH
   find . -name "*.bc" | grep -v R.bin.bc | grep -v '\.o\.bc' | grep -v '\.svn' | grep -v '^./packages' | while read F ; do
     FOUT=`echo $F | sed -e 's/\.bc$/.'$T'/g'`
     if [ ! -r $FOUT ] || [ $F -nt $FOUT ] || [ ./src/main/R.bin.bc -nt $FOUT ] ; then
-      $RCHK/src/$T ./src/main/R.bin.bc $F >$FOUT 2>&1
+      if [ $T == fficheck ] ; then
+        $RCHK/src/$T ./src/main/R.bin.bc $F >$FOUT 2>&1
+      else
+        echo "$F $FOUT" >> $BATCH
+      fi
     fi
   done
+  if [ -s $BATCH ] ; then
+    $RCHK/src/$T --batch $BATCH ./src/main/R.bin.bc
+  fi
 done
@@ -0,0 +1,75 @@
+#! /bin/bash
+
+# compares the time of finding the called functions that may reach an allocator
+# by the original full transitive closure of the allocator call graphs and by
+# the reverse search used now (--benchmark-closure, see src/callocators.h)
+#
+# the tool also checks that both give the same result (it fails with an
+# assertion when they do not)
+#
+# Usage:
+#
+#   closure_bench.sh tool base.bc [module.bc]
+#
+# Environment variables:
+#
+#   RUNS         number of runs (default 3)
+#
+# Examples:
+#
+#   ./closure_bench.sh alloccheck ./src/main/R.bin.bc
+#   ./closure_bench.sh csfpcheck ./src/main/R.bin.bc ./packages/lib/png/libs/png.so.bc
+
+if [ $# -lt 2 ] || [ $# -gt 3 ] ; then
+  echo "Usage: $0 tool base.bc [module.bc]" >&2
+  exit 2
+fi
+
+if [ X"$RCHK" == X ] ; then
+  RCHK=`dirname $0`/..
+fi
+
+T=$1
+shift
+
+RUNS=${RUNS:-3}
+
+if [ ! -x $RCHK/src/$T ] ; then
+  echo "Cannot find $RCHK/src/$T, please build rchk." >&2
+  exit 2
+fi
+
+WORK=`mktemp -d`
+trap "rm -rf $WORK" EXIT
+
+# the tool reports lines like
+#   Closure of calls of 12345 called functions: matrix 1.234s, reverse search 0.012s
+
+for ((R = 0; R < RUNS; R++)) ; do
+  if ! $RCHK/src/$T --benchmark-closure "$@" >$WORK/out.$R 2>&1 ; then
+    echo "Running $T failed, see the output below." >&2
+    cat $WORK/out.$R >&2
+    exit 1
+  fi
+  grep '^Closure of ' $WORK/out.$R >>$WORK/times
+done
+
+if [ ! -s $WORK/times ] ; then
+  echo "$T did not report any closure times (does it use context-sensitive allocators?)" >&2
+  exit 1
+fi
+
+echo "$T: $RUNS run(s)"
+awk '
+  {
+    graph = $3; n[graph] = $5
+    m = $9; sub(/s,$/, "", m); matrix[graph] += m
+    s = $12; sub(/s$/, "", s); search[graph] += s
+    runs[graph]++
+  }
+  END {
+    for (graph in runs) {
+      printf "  %s (%d called functions): matrix %.3f s, reverse search %.3f s\n", graph, n[graph], matrix[graph] / runs[graph], search[graph] / runs[graph]
+    }
+  }
+' $WORK/times
@@ -0,0 +1,127 @@
+#! /bin/bash
+
+# compares the time and memory of checking modules with the base module read
+# fully and with bodies of base functions read only when needed (--lazy, see
+# src/lazy.h)
+#
+# both variants use the same analyses cache (--cache-dir, see src/cache.h),
+# which is populated by the script before the measurements, so only the
+# checking of the modules is measured
+#
+# Usage:
+#
+#   lazy_bench.sh tool base.bc module1.bc [module2.bc ...]
+#
+# Environment variables:
+#
+#   RUNS         number of runs of each variant for each module (default 3)
+#
+# Examples:
+#
+#   ./lazy_bench.sh bcheck ./src/main/R.bin.bc ./packages/lib/png/libs/png.so.bc
+
+if [ $# -lt 3 ] ; then
+  echo "Usage: $0 tool base.bc module1.bc [module2.bc ...]" >&2
+  exit 2
+fi
+
+if [ X"$RCHK" == X ] ; then
+  RCHK=`dirname $0`/..
+fi
+
+T=$1
+RBC=$2
+shift 2
+MODULES=("$@")
+
+RUNS=${RUNS:-3}
+
+if [ ! -x $RCHK/src/$T ] ; then
+  echo "Cannot find $RCHK/src/$T, please build rchk." >&2
+  exit 2
+fi
+
+WORK=`mktemp -d`
+CACHE=$WORK/cache
+mkdir $CACHE
+
+function now {
+  date +%s%N
+}
+
+function elapsed {
+  local MS=$(($1 / 1000000))
+  printf "%d.%03d" $((MS / 1000)) $((MS % 1000))
+}
+
+# runs the tool, the output goes to file $1, the peak resident memory (in kB)
+# to file $1.rss; the peak is sampled when GNU time is not available, which
+# is only approximate for short runs
+
+if [ -x /usr/bin/time ] ; then
+  RSS_NOTE=
+else
+  RSS_NOTE=" (sampled)"
+fi
+
+function run {
+  local OUT=$1
+  shift
+  if [ -x /usr/bin/time ] ; then
+    /usr/bin/time -f %M -o $OUT.rss $RCHK/src/$T "$@" >$OUT 2>&1
+  else
+    $RCHK/src/$T "$@" >$OUT 2>&1 &
+    local PID=$!
+    local HWM=0
+    while kill -0 $PID 2>/dev/null ; do
+      local KB=`awk '/^VmHWM:/ { print $2 }' /proc/$PID/status 2>/dev/null`
+      if [ X"$KB" != X ] && [ $KB -gt $HWM ] ; then
+        HWM=$KB
+      fi
+      sleep 0.05
+    done
+    wait $PID
+    echo $HWM >$OUT.rss
+  fi
+}
+
+# populate the cache
+
+for M in "${MODULES[@]}" ; do
+  $RCHK/src/$T --cache-dir $CACHE $RBC $M >/dev/null 2>&1
+done
+
+# measure
+
+NDIFF=0
+for V in eager lazy ; do
+  TIME=0
+  RSS=0
+  OPTS="--cache-dir $CACHE"
+  if [ $V == lazy ] ; then
+    OPTS="$OPTS --lazy"
+  fi
+  for ((I = 0; I < ${#MODULES[@]}; I++)) ; do
+    for ((R = 0; R < RUNS; R++)) ; do
+      START=`now`
+      run $WORK/$V.$I.out $OPTS $RBC ${MODULES[$I]}
+      TIME=$((TIME + `now` - START))
+      KB=`cat $WORK/$V.$I.out.rss`
+      if [ $KB -gt $RSS ] ; then
+        RSS=$KB
+      fi
+    done
+    if [ $V == lazy ] && ! cmp -s <(sort $WORK/eager.$I.out) <(sort $WORK/lazy.$I.out) ; then
+      NDIFF=$((NDIFF + 1))
+    fi
+  done
+  eval ${V}_TIME=`elapsed $((TIME / RUNS))`
+  eval ${V}_RSS=$RSS
+done
+
+echo "$T: ${#MODULES[@]} module(s), $RUNS run(s) each, with a populated cache"
+echo "  eager: $eager_TIME s, peak resident memory $eager_RSS kB$RSS_NOTE"
+echo "  lazy:  $lazy_TIME s, peak resident memory $lazy_RSS kB$RSS_NOTE"
+echo "  outputs differing from eager runs: $NDIFF"
+
+rm -rf $WORK
@@ -0,0 +1,128 @@
+#! /bin/bash
+
+# compares the time of checking modules by separate runs of a tool and by requests
+# to the tool running as a server (--server, see src/server.h)
+#
+# runs locally, the server is started and stopped by the script
+#
+# Usage:
+#
+#   server_loadtest.sh tool base.bc module1.bc [module2.bc ...]
+#
+# Environment variables:
+#
+#   REQUESTS     number of requests (default 20), the modules are used in turns
+#   CLIENTS      number of clients sending requests at the same time (default 4)
+#   SERVER_JOBS  number of modules checked by the server at the same time (default CLIENTS)
+#
+# Examples:
+#
+#   REQUESTS=100 ./server_loadtest.sh bcheck ./src/main/R.bin.bc ./packages/lib/png/libs/png.so.bc
+
+if [ $# -lt 3 ] ; then
+  echo "Usage: $0 tool base.bc module1.bc [module2.bc ...]" >&2
+  exit 2
+fi
+
+if [ X"$RCHK" == X ] ; then
+  RCHK=`dirname $0`/..
+fi
+
+T=$1
+RBC=$2
+shift 2
+MODULES=("$@")
+
+REQUESTS=${REQUESTS:-20}
+CLIENTS=${CLIENTS:-4}
+SERVER_JOBS=${SERVER_JOBS:-$CLIENTS}
+
+for P in $RCHK/src/$T $RCHK/src/rchkclient ; do
+  if [ ! -x $P ] ; then
+    echo "Cannot find $P, please build rchk." >&2
+    exit 2
+  fi
+done
+
+WORK=`mktemp -d`
+SOCKET=$WORK/$T.sock
+
+function now {
+  date +%s%N
+}
+
+function elapsed {
+  local MS=$((($2 - $1) / 1000000))
+  printf "%d.%03d" $((MS / 1000)) $((MS % 1000))
+}
+
+# sends requests number $1, $1+CLIENTS, ... (one client)
+
+function client {
+  for ((I = $1; I < REQUESTS; I += CLIENTS)) ; do
+    M=${MODULES[$((I % ${#MODULES[@]}))]}
+    if ! $RCHK/src/rchkclient $SOCKET $M $WORK/server.$I.out ; then
+      echo "Request $I ($M) failed." >&2
+    fi
+  done
+}
+
+# separate runs (CLIENTS at the same time)
+
+START=`now`
+for ((C = 0; C < CLIENTS; C++)) ; do
+  (
+    for ((I = C; I < REQUESTS; I += CLIENTS)) ; do
+      M=${MODULES[$((I % ${#MODULES[@]}))]}
+      $RCHK/src/$T $RBC $M >$WORK/separate.$I.out 2>&1
+    done
+  ) &
+done
+wait
+SEPARATE=`elapsed $START \`now\``
+
+# server
+
+START=`now`
+$RCHK/src/$T --server $SOCKET --server-jobs $SERVER_JOBS $RBC 2>$WORK/server.log &
+SERVER=$!
+while [ ! -S $SOCKET ] ; do
+  if ! kill -0 $SERVER 2>/dev/null ; then
+    echo "The server failed to start:" >&2
+    cat $WORK/server.log >&2
+    rm -rf $WORK
+    exit 1
+  fi
+  sleep 0.1
+done
+READY=`now`
+
+CLIENT_PIDS=
+for ((C = 0; C < CLIENTS; C++)) ; do
+  client $C &
+  CLIENT_PIDS="$CLIENT_PIDS $!"
+done
+wait $CLIENT_PIDS
+DONE=`now`
+kill -TERM $SERVER
+wait $SERVER
+
+STARTUP=`elapsed $START $READY`
+SERVED=`elapsed $READY $DONE`
+
+# the outputs should not differ (other than in the order of lines)
+
+NDIFF=0
+for ((I = 0; I < REQUESTS; I++)) ; do
+  if ! cmp -s <(sort $WORK/separate.$I.out) <(sort $WORK/server.$I.out) ; then
+    NDIFF=$((NDIFF + 1))
+  fi
+done
+
+echo "$T: $REQUESTS checks of ${#MODULES[@]} module(s), $CLIENTS at the same time"
+echo "  separate runs:   $SEPARATE s"
+echo "  server startup:  $STARTUP s"
+echo "  server requests: $SERVED s"
+echo "  outputs differing from separate runs: $NDIFF"
+
+rm -rf $WORK
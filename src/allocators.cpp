@@ -1,6 +1,8 @@
 
 #include "allocators.h"
+#include "cache.h"
 #include "exceptions.h"
+#include "lazy.h"
 #include "patterns.h"
 
 using namespace llvm;
@@ -182,25 +184,84 @@ void getWrappedAllocators(Function *f, FunctionsSetTy& wrappedAllocators, Functi
   }
 }
 
+// extends results cached for the base module (see cache.h) to the functions of a linked package
+//   a candidate (package function) is added when it (transitively) calls the GC function or a base
+//   function in the result; only the given edges are followed (all calls when edges are NULL), and
+//   not from the base functions, which cannot call the package
+
+static void extendToPackageFunctions(Module *m, FunctionsSetTy& result, FunctionsSetTy& candidates, CallEdgesMapTy *edges) {
+
+  FunctionsSetTy onlyFunctions(candidates);
+  onlyFunctions.insert(result.begin(), result.end()); // includes the GC function
+  
+  CallEdgesMapTy allEdges;
+  if (!edges) {
+    for(FunctionsSetTy::iterator ci = candidates.begin(), ce = candidates.end(); ci != ce; ++ci) {
+      allEdges.insert({*ci, &onlyFunctions});
+    }
+    edges = &allEdges;
+  }
+
+  FunctionsInfoMapTy functionsMap;
+  buildCGClosure(m, functionsMap, true /* ignore error paths */, &onlyFunctions, edges, getGCFunction(m) /* assume external functions allocate */);
+  
+  for(FunctionsSetTy::iterator ci = candidates.begin(), ce = candidates.end(); ci != ce; ++ci) {
+    Function *f = *ci;
+    auto fsearch = functionsMap.find(f);
+    if (fsearch == functionsMap.end()) {
+      continue;
+    }
+    std::vector<FunctionInfo*>& called = fsearch->second.calledFunctionsList;
+    for(std::vector<FunctionInfo*>::iterator ti = called.begin(), te = called.end(); ti != te; ++ti) {
+      Function *t = const_cast<Function *>((*ti)->function);
+      if (candidates.find(t) == candidates.end()) { // a base function in the result
+        result.insert(f);
+        break;
+      }
+    }
+  }
+}
+
+static void addWrapperEdges(Function *f, Function *gcFunction, FunctionsSetTy& onlyFunctions, CallEdgesMapTy& onlyEdges) {
+
+  if (isKnownNonAllocator(f) || isAssertedNonAllocating(f)) {
+    return;
+  }
+  FunctionsSetTy wrappedAllocators;
+  getWrappedAllocators(f, wrappedAllocators, gcFunction);
+  if (!wrappedAllocators.empty()) {
+    onlyEdges.insert({f, new FunctionsSetTy(wrappedAllocators)});
+    onlyFunctions.insert(f);
+  }
+}
+
 void findPossibleAllocators(Module *m, FunctionsSetTy& possibleAllocators) {
 
   FunctionsSetTy onlyFunctions;
   CallEdgesMapTy onlyEdges;
   Function* gcFunction = getGCFunction(m);
+  
+  if (analysesCache.getFunctions(m, "possibleAllocators", possibleAllocators)) {
+    if (analysesCache.isLinked()) {
+      FunctionsVectorTy packageFunctions;
+      analysesCache.getPackageFunctions(packageFunctions);
+      for(FunctionsVectorTy::iterator fi = packageFunctions.begin(), fe = packageFunctions.end(); fi != fe; ++fi) {
+        addWrapperEdges(*fi, gcFunction, onlyFunctions, onlyEdges);
+      }
+      extendToPackageFunctions(m, possibleAllocators, onlyFunctions, &onlyEdges);
+      
+      for(CallEdgesMapTy::iterator cei = onlyEdges.begin(), cee = onlyEdges.end(); cei != cee; ++cei) {
+        delete cei->second;
+      }
+    }
+    return;
+  }
 
+  materializeModule(m);
   onlyFunctions.insert(gcFunction);
   for(Module::iterator fi = m->begin(), fe = m->end(); fi != fe; ++fi) {
     Function *f = &*fi;
-
-    if (isKnownNonAllocator(f) || isAssertedNonAllocating(f)) {
-      continue;
-    }
-    FunctionsSetTy wrappedAllocators;
-    getWrappedAllocators(f, wrappedAllocators, gcFunction);
-    if (!wrappedAllocators.empty()) {
-      onlyEdges.insert({f, new FunctionsSetTy(wrappedAllocators)});
-      onlyFunctions.insert(f);
-    }
+    addWrapperEdges(f, gcFunction, onlyFunctions, onlyEdges);
   }
   
   FunctionsInfoMapTy functionsMap;
@@ -222,6 +283,7 @@ void findPossibleAllocators(Module *m, FunctionsSetTy& possibleAllocators) {
   }
   
   possibleAllocators.insert(gcFunction);
+  analysesCache.putFunctions(m, "possibleAllocators", possibleAllocators);
 }
 
 bool isAllocatingFunction(Function *fun, FunctionsInfoMapTy& functionsMap, unsigned gcFunctionIndex) {
@@ -241,7 +303,23 @@ bool isAllocatingFunction(Function *fun, FunctionsInfoMapTy& functionsMap, unsig
 void findAllocatingFunctions(Module *m, FunctionsSetTy& allocatingFunctions) {
 
   FunctionsSetTy onlyFunctions;
+  
+  if (analysesCache.getFunctions(m, "allocatingFunctions", allocatingFunctions)) {
+    if (analysesCache.isLinked()) {
+      FunctionsVectorTy packageFunctions;
+      analysesCache.getPackageFunctions(packageFunctions);
+      for(FunctionsVectorTy::iterator fi = packageFunctions.begin(), fe = packageFunctions.end(); fi != fe; ++fi) {
+        Function *f = *fi;
+        if (!isAssertedNonAllocating(f)) {
+          onlyFunctions.insert(f);
+        }
+      }
+      extendToPackageFunctions(m, allocatingFunctions, onlyFunctions, NULL);
+    }
+    return;
+  }
 
+  materializeModule(m);
   for(Module::iterator fi = m->begin(), fe = m->end(); fi != fe; ++fi) {
     Function *f = &*fi;
     if (!isAssertedNonAllocating(f)) {
@@ -263,4 +341,5 @@ void findAllocatingFunctions(Module *m, FunctionsSetTy& allocatingFunctions) {
     }
   }
   allocatingFunctions.insert(getGCFunction(m));
+  analysesCache.putFunctions(m, "allocatingFunctions", allocatingFunctions);
 }
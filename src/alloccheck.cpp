@@ -19,24 +19,20 @@
 #include "callocators.h"
 #include "errors.h"
 #include "cprotect.h"
+#include "tools.h"
 
 using namespace llvm;
 
-int main(int argc, char* argv[])
+static int runAlloccheck(ModuleAnalysesTy& analyses, FunctionsOrderedSetTy& functionsOfInterestSet, FunctionsVectorTy& functionsOfInterestVector)
 {
-  LLVMContext context;
-
-  FunctionsOrderedSetTy functionsOfInterestSet;
-  FunctionsVectorTy functionsOfInterestVector;
-  Module *m = parseArgsReadIR(argc, argv, functionsOfInterestSet, functionsOfInterestVector, context);
-  CalledModuleTy *cm = CalledModuleTy::create(m);
+  CalledModuleTy *cm = analyses.getCalledModule();
 
   FunctionsSetTy *possibleAllocators = cm->getPossibleAllocators();
   FunctionsSetTy *allocatingFunctions = cm->getAllocatingFunctions();
   const CalledFunctionsIndexTy* calledFunctions = cm->getCalledFunctions();
 
   outs() << "Callee protect functions: \n";
-  CProtectInfo cprotect = findCalleeProtectFunctions(m, *cm->getContextSensitiveAllocatingFunctions());
+  CProtectInfo& cprotect = *analyses.getCalleeProtect();
   for(FunctionsVectorTy::iterator fi = functionsOfInterestVector.begin(), fe = functionsOfInterestVector.end(); fi != fe; ++fi) {
     Function *fun = *fi;
     if (cprotect.isCalleeProtect(fun, true /* non-trivially */)) {
@@ -206,6 +202,14 @@ int main(int argc, char* argv[])
     }
   }
 
-  CalledModuleTy::release(cm);  
-  delete m;
+  return 0;
+}
+
+const ToolTy alloccheckTool = {"alloccheck", NULL, runAlloccheck, false, false};
+
+#ifndef RCHK_DRIVER
+int main(int argc, char* argv[])
+{
+  return runTool(alloccheckTool, argc, argv);
 }
+#endif
@@ -0,0 +1,165 @@
+
+#include "analyses.h"
+#include "allocators.h"
+#include "errors.h"
+#include "lazy.h"
+#include "shard.h"
+
+#include <llvm/IR/LLVMContext.h>
+
+using namespace llvm;
+
+ModuleAnalysesTy::ModuleAnalysesTy(Module *m): m(m), errorFunctions(NULL), symbolsMap(NULL), globals(NULL),
+  possibleAllocators(NULL), allocatingFunctions(NULL), cgClosure(NULL), gcFunctionIndex(0), calledModule(NULL), calleeProtect(NULL) {}
+
+ModuleAnalysesTy::~ModuleAnalysesTy() {
+
+  // the called module and callee-protect info refer to the other analyses
+  if (calleeProtect) {
+    delete calleeProtect;
+  }
+  if (calledModule) {
+    delete calledModule;
+  }
+  if (cgClosure) {
+    delete cgClosure;
+  }
+  if (allocatingFunctions) {
+    delete allocatingFunctions;
+  }
+  if (possibleAllocators) {
+    delete possibleAllocators;
+  }
+  if (globals) {
+    delete globals;
+  }
+  if (symbolsMap) {
+    delete symbolsMap;
+  }
+  if (errorFunctions) {
+    delete errorFunctions;
+  }
+}
+
+FunctionsSetTy* ModuleAnalysesTy::getErrorFunctions() {
+
+  if (!errorFunctions) {
+    errorFunctions = new FunctionsSetTy();
+    findErrorFunctions(m, *errorFunctions);
+  }
+  return errorFunctions;
+}
+
+SymbolsMapTy* ModuleAnalysesTy::getSymbolsMap() {
+
+  if (!symbolsMap) {
+    symbolsMap = new SymbolsMapTy();
+    findSymbols(m, symbolsMap);
+  }
+  return symbolsMap;
+}
+
+GlobalsTy* ModuleAnalysesTy::getGlobals() {
+
+  if (!globals) {
+    globals = new GlobalsTy(m);
+  }
+  return globals;
+}
+
+FunctionsSetTy* ModuleAnalysesTy::getPossibleAllocators() {
+
+  if (!possibleAllocators) {
+    possibleAllocators = new FunctionsSetTy();
+    findPossibleAllocators(m, *possibleAllocators);
+  }
+  return possibleAllocators;
+}
+
+FunctionsSetTy* ModuleAnalysesTy::getAllocatingFunctions() {
+
+  if (!allocatingFunctions) {
+    allocatingFunctions = new FunctionsSetTy();
+    findAllocatingFunctions(m, *allocatingFunctions);
+  }
+  return allocatingFunctions;
+}
+
+FunctionsInfoMapTy* ModuleAnalysesTy::getCGClosure() {
+
+  if (!cgClosure) {
+    cgClosure = new FunctionsInfoMapTy();
+    buildCGClosure(m, *cgClosure, true /* ignore error paths */);
+    gcFunctionIndex = ::getGCFunctionIndex(*cgClosure, m);
+  }
+  return cgClosure;
+}
+
+unsigned ModuleAnalysesTy::getGCFunctionIndex() {
+
+  getCGClosure();
+  return gcFunctionIndex;
+}
+
+CalledModuleTy* ModuleAnalysesTy::getCalledModule() {
+
+  if (!calledModule) {
+    // the same order of computation as in CalledModuleTy::create
+    SymbolsMapTy *symbolsMap = getSymbolsMap();
+    FunctionsSetTy *errorFunctions = getErrorFunctions();
+    GlobalsTy *globals = getGlobals();
+    FunctionsSetTy *possibleAllocators = getPossibleAllocators();
+    FunctionsSetTy *allocatingFunctions = getAllocatingFunctions();
+    calledModule = new CalledModuleTy(m, symbolsMap, errorFunctions, globals, possibleAllocators, allocatingFunctions);
+  }
+  return calledModule;
+}
+
+CProtectInfo* ModuleAnalysesTy::getCalleeProtect() {
+
+  if (!calleeProtect) {
+    calleeProtect = new CProtectInfo(findCalleeProtectFunctions(m, *getCalledModule()->getContextSensitiveAllocatingFunctions()));
+  }
+  return calleeProtect;
+}
+
+int runTool(const ToolTy& tool, int argc, char* argv[]) {
+
+  LLVMContext context;
+  FunctionsOrderedSetTy functionsOfInterestSet;
+  FunctionsVectorTy functionsOfInterestVector;
+
+  if (tool.extractOptions && !tool.extractOptions(argc, argv)) {
+    exit(1);
+  }
+  Module *m = parseArgsReadIR(argc, argv, functionsOfInterestSet, functionsOfInterestVector, context);
+  if (tool.allFunctions) {
+    materializeModule(m);
+  }
+
+  int res;
+  {
+    ModuleAnalysesTy analyses(m);
+    res = runToolOnShard(tool, analyses, functionsOfInterestSet, functionsOfInterestVector);
+  }
+  delete m;
+  return res;
+}
+
+int runToolOnShard(const ToolTy& tool, ModuleAnalysesTy& analyses, FunctionsOrderedSetTy& functionsOfInterestSet, FunctionsVectorTy& functionsOfInterestVector) {
+
+  if (!shardOptions.enabled()) {
+    return tool.run(analyses, functionsOfInterestSet, functionsOfInterestVector);
+  }
+  if (!tool.split) {
+    if (shardOptions.index != 1) {
+      return 0; // the output of the whole tool is in part 1
+    }
+    return tool.run(analyses, functionsOfInterestSet, functionsOfInterestVector);
+  }
+
+  FunctionsOrderedSetTy shardSet;
+  FunctionsVectorTy shardVector;
+  selectShard(functionsOfInterestVector, shardSet, shardVector);
+  return tool.run(analyses, shardSet, shardVector);
+}
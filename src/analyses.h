@@ -0,0 +1,75 @@
+#ifndef RCHK_ANALYSES_H
+#define RCHK_ANALYSES_H
+
+#include "common.h"
+#include "callocators.h"
+#include "cgclosure.h"
+#include "cprotect.h"
+#include "symbols.h"
+
+#include <llvm/IR/Module.h>
+
+using namespace llvm;
+
+// module-wide analyses needed by the tools
+//   each analysis is computed on first use and then kept, so when several
+//   tools run in one process (see rchk.cpp), it is computed at most once and
+//   shared by them
+//
+//   the analyses are computed as the tools used to compute them on their own;
+//   they are released with the manager, which must not outlive the module
+
+class ModuleAnalysesTy {
+
+  Module *m;
+
+  FunctionsSetTy *errorFunctions;
+  SymbolsMapTy *symbolsMap;
+  GlobalsTy *globals;
+  FunctionsSetTy *possibleAllocators;
+  FunctionsSetTy *allocatingFunctions;
+  FunctionsInfoMapTy *cgClosure;
+  unsigned gcFunctionIndex;
+  CalledModuleTy *calledModule;
+  CProtectInfo *calleeProtect;
+
+  public:
+    ModuleAnalysesTy(Module *m);
+    ~ModuleAnalysesTy();
+
+    Module *getModule() { return m; }
+
+    FunctionsSetTy* getErrorFunctions(); // findErrorFunctions
+    SymbolsMapTy* getSymbolsMap(); // findSymbols
+    GlobalsTy* getGlobals();
+    FunctionsSetTy* getPossibleAllocators(); // findPossibleAllocators
+    FunctionsSetTy* getAllocatingFunctions(); // findAllocatingFunctions
+
+    FunctionsInfoMapTy* getCGClosure(); // buildCGClosure, ignoring error paths
+    unsigned getGCFunctionIndex(); // index of the GC function in the closure
+
+    CalledModuleTy* getCalledModule(); // built from the analyses above
+    CProtectInfo* getCalleeProtect(); // findCalleeProtectFunctions, with context-sensitive allocating functions
+};
+
+// a tool that can be run on its own or by the driver with other tools
+//   options of the tool are extracted before the IR is read (false on invalid
+//   options); run returns the exit status of the tool
+
+typedef bool (*ExtractToolOptionsTy)(int& argc, char* argv[]);
+typedef int (*RunToolTy)(ModuleAnalysesTy& analyses, FunctionsOrderedSetTy& functionsOfInterestSet, FunctionsVectorTy& functionsOfInterestVector);
+
+struct ToolTy {
+  const char *name;
+  ExtractToolOptionsTy extractOptions; // NULL when the tool has no options of its own
+  RunToolTy run;
+  bool allFunctions; // reports on all functions of the module, not only those of interest, so needs all bodies with --lazy
+  bool split; // checks the functions of interest one by one, so they can be split by --shard (see shard.h)
+};
+
+int runTool(const ToolTy& tool, int argc, char* argv[]); // the main function of a single tool
+
+// runs the tool on the functions of the current part with --shard
+int runToolOnShard(const ToolTy& tool, ModuleAnalysesTy& analyses, FunctionsOrderedSetTy& functionsOfInterestSet, FunctionsVectorTy& functionsOfInterestVector);
+
+#endif
@@ -0,0 +1,100 @@
+
+#include "arena.h"
+#include "common.h"
+
+#include <cstdlib>
+#include <cstring>
+
+Arena::Arena(): chunks(), currentChunk(0), next(NULL), end(NULL), largeBlocks() {
+  memset(freeLists, 0, sizeof(freeLists));
+}
+
+Arena::~Arena() {
+  reset();
+  for(std::vector<char*>::iterator ci = chunks.begin(), ce = chunks.end(); ci != ce; ++ci) {
+    free(*ci);
+  }
+}
+
+void Arena::newChunk() {
+
+  if (next) {
+    currentChunk++;
+  }
+  if (currentChunk == chunks.size()) {
+    char *chunk = (char *) malloc(CHUNK_SIZE);
+    myassert(chunk);
+    chunks.push_back(chunk);
+  }
+  next = chunks[currentChunk];
+  end = next + CHUNK_SIZE;
+}
+
+// a large block starts with the index of its entry in largeBlocks (padded to ALIGN)
+
+void* Arena::allocate(size_t size) {
+
+  if (size > MAX_SMALL) {
+    char *block = (char *) malloc(ALIGN + size);
+    myassert(block);
+    *(size_t *) block = largeBlocks.size();
+    largeBlocks.push_back(block);
+    return block + ALIGN;
+  }
+
+  size_t asize = (size + ALIGN - 1) & ~(ALIGN - 1);
+  if (asize == 0) {
+    asize = ALIGN;
+  }
+  FreeBlockTy*& freeList = freeLists[asize / ALIGN];
+  if (freeList) {
+    FreeBlockTy *res = freeList;
+    freeList = res->next;
+    return res;
+  }
+
+  if (!next || next + asize > end) {
+    newChunk();
+  }
+  void *res = next;
+  next += asize;
+  return res;
+}
+
+void Arena::deallocate(void *p, size_t size) {
+
+  if (size > MAX_SMALL) {
+    char *block = (char *) p - ALIGN;
+    largeBlocks[*(size_t *) block] = NULL;
+    free(block);
+    return;
+  }
+
+  size_t asize = (size + ALIGN - 1) & ~(ALIGN - 1);
+  if (asize == 0) {
+    asize = ALIGN;
+  }
+  FreeBlockTy*& freeList = freeLists[asize / ALIGN];
+  FreeBlockTy *block = (FreeBlockTy *) p;
+  block->next = freeList;
+  freeList = block;
+}
+
+void Arena::reset() {
+
+  for(std::vector<char*>::iterator bi = largeBlocks.begin(), be = largeBlocks.end(); bi != be; ++bi) {
+    free(*bi); // may be NULL
+  }
+  largeBlocks.clear();
+
+  // keep some chunks to be reused, but do not hold all memory needed by the
+  // largest function checked so far
+  while(chunks.size() > KEEP_CHUNKS) {
+    free(chunks.back());
+    chunks.pop_back();
+  }
+  memset(freeLists, 0, sizeof(freeLists));
+  currentChunk = 0;
+  next = NULL;
+  end = NULL;
+}
@@ -0,0 +1,70 @@
+#ifndef RCHK_ARENA_H
+#define RCHK_ARENA_H
+
+#include <cstddef>
+#include <vector>
+
+// a region allocator for objects that all die at the same time, such as the
+// states explored when checking a single function
+//
+//   memory is taken from large chunks by bumping a pointer; freed small blocks
+//   are kept in free lists by size, so that objects that die soon after being
+//   allocated (e.g. states that turn out to be duplicates) are recycled without
+//   growing the arena; large blocks (e.g. bucket arrays of hash tables) are
+//   allocated separately, but they are also owned by the arena
+//
+//   reset() releases all memory of the arena at once, the cost depends on the
+//   number of chunks and large blocks, but not on the number of objects
+//
+//   a container allocating from an arena does not have to be destroyed before
+//   the arena is reset: it can be abandoned and a new one created in its place
+//   (see clearStates in bcheck.cpp), as long as its elements do not own any
+//   memory outside of the arena (i.e. they are trivially destructible)
+
+class Arena {
+
+  static const size_t CHUNK_SIZE = 1 << 20;
+  static const size_t ALIGN = 16;
+  static const size_t MAX_SMALL = 1024;
+  static const unsigned KEEP_CHUNKS = 4; // chunks kept for reuse after reset
+
+  struct FreeBlockTy {
+    FreeBlockTy *next;
+  };
+
+  std::vector<char*> chunks;
+  unsigned currentChunk;
+  char *next;
+  char *end;
+  FreeBlockTy* freeLists[MAX_SMALL / ALIGN + 1];
+  std::vector<char*> largeBlocks; // NULL when freed already
+
+  void newChunk();
+
+  public:
+    Arena();
+    ~Arena();
+
+    void* allocate(size_t size);
+    void deallocate(void *p, size_t size);
+    void reset(); // all memory from the arena is invalidated
+};
+
+// allocator for standard containers
+
+template<class T> struct ArenaAllocator {
+  typedef T value_type;
+
+  Arena *arena;
+
+  ArenaAllocator(Arena *arena): arena(arena) {}
+  template<class U> ArenaAllocator(const ArenaAllocator<U>& other): arena(other.arena) {}
+
+  T* allocate(size_t n) { return static_cast<T*>(arena->allocate(n * sizeof(T))); }
+  void deallocate(T* p, size_t n) { arena->deallocate(p, n * sizeof(T)); }
+};
+
+template<class T, class U> bool operator==(const ArenaAllocator<T>& lhs, const ArenaAllocator<U>& rhs) { return lhs.arena == rhs.arena; }
+template<class T, class U> bool operator!=(const ArenaAllocator<T>& lhs, const ArenaAllocator<U>& rhs) { return lhs.arena != rhs.arena; }
+
+#endif
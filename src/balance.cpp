@@ -491,6 +491,24 @@ void handleBalanceForNonTerminator(Instruction *in, BalanceStateTy& b, GlobalsTy
   }
 }
 
+static bool evaluateComparison(CmpInst::Predicate pred, const APInt& lhs, const APInt& rhs) {
+  switch(pred) {
+    case CmpInst::ICMP_EQ: return lhs.eq(rhs);
+    case CmpInst::ICMP_NE: return lhs.ne(rhs);
+    case CmpInst::ICMP_UGT: return lhs.ugt(rhs);
+    case CmpInst::ICMP_UGE: return lhs.uge(rhs);
+    case CmpInst::ICMP_ULT: return lhs.ult(rhs);
+    case CmpInst::ICMP_ULE: return lhs.ule(rhs);
+    case CmpInst::ICMP_SGT: return lhs.sgt(rhs);
+    case CmpInst::ICMP_SGE: return lhs.sge(rhs);
+    case CmpInst::ICMP_SLT: return lhs.slt(rhs);
+    case CmpInst::ICMP_SLE: return lhs.sle(rhs);
+    default:
+      myassert(false);
+      return false;
+  }
+}
+
 bool handleBalanceForTerminator(TerminatorInst* t, StateWithBalanceTy& s, GlobalsTy& g, VarBoolCacheTy& counterVarsCache, 
     LineMessenger& msg, unsigned& refinableInfos) {
 
@@ -564,14 +582,17 @@ bool handleBalanceForTerminator(TerminatorInst* t, StateWithBalanceTy& s, Global
     //
     // if (nprotect??const) { .... }
                   
-    Constant *knownLhs = ConstantInt::getSigned(s.balance.counterVar->getAllocatedType(), s.balance.count);
-    Constant *res = ConstantExpr::getCompare(ci->getPredicate(), knownLhs, constOp);
-    myassert(ConstantInt::classof(res));
+    if (!ConstantInt::classof(constOp)) {
+      return false;
+    }
+    const APInt& rhs = cast<ConstantInt>(constOp)->getValue();
+    APInt knownLhs(rhs.getBitWidth(), (uint64_t) s.balance.count, true /* signed */);
+      // not creating a constant expression, that would modify the LLVM context (functions may be checked in parallel)
                 
     // add only the relevant successor
     if (msg.debug()) msg.debug(MSG_PFX + "folding out branch on counter value", t);
     BasicBlock *succ;
-    if (!res->isZeroValue()) {
+    if (evaluateComparison(ci->getPredicate(), knownLhs, rhs)) {
       succ = br->getSuccessor(0);
     } else {
       succ = br->getSuccessor(1);
@@ -36,12 +36,17 @@ struct BalanceStateTy {
   
   BalanceStateTy(int depth, int savedDepth, int count, CountState countState, AllocaInst* counterVar, AllocaInst* topSaveVar, bool confused):
     depth(depth), savedDepth(savedDepth), count(count), countState(countState), counterVar(counterVar), topSaveVar(topSaveVar), confused(confused) {};
+
+  bool operator==(const BalanceStateTy& other) const {
+    return depth == other.depth && savedDepth == other.savedDepth && count == other.count && countState == other.countState &&
+      counterVar == other.counterVar && topSaveVar == other.topSaveVar && confused == other.confused;
+  }
 };
 
 struct StateWithBalanceTy : virtual public StateBaseTy {
   BalanceStateTy balance;
   
-  StateWithBalanceTy(BasicBlock *bb, BalanceStateTy& balance): StateBaseTy(bb), balance(balance) {};
+  StateWithBalanceTy(BasicBlock *bb, const BalanceStateTy& balance): StateBaseTy(bb), balance(balance) {};
   StateWithBalanceTy(BasicBlock *bb): StateBaseTy(bb), balance(0, -1, -1, CS_NONE, NULL, NULL, false) {};
   
   virtual StateWithBalanceTy* clone(BasicBlock *newBB) = 0;
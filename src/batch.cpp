@@ -0,0 +1,164 @@
+
+#include "batch.h"
+#include "cache.h"
+#include "common.h"
+
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <llvm/Support/raw_ostream.h>
+
+using namespace llvm;
+
+BatchOptionsTy batchOptions;
+
+bool extractBatchOptions(int& argc, char* argv[]) {
+
+  if (extractOption(argc, argv, "batch", batchOptions.listFname) && batchOptions.listFname.empty()) {
+    errs() << "Invalid batch file\n";
+    return false;
+  }
+  return true;
+}
+
+struct BatchEntryTy {
+  std::string moduleFname;
+  std::string outputFname;
+};
+
+typedef std::vector<BatchEntryTy> BatchEntriesTy;
+
+static bool readBatchFile(const std::string& listFname, BatchEntriesTy& entries) {
+
+  std::ifstream in(listFname);
+  if (!in) {
+    errs() << "ERROR: Cannot read batch file " << listFname << "\n";
+    return false;
+  }
+  std::string line;
+  unsigned lineno = 0;
+  while(std::getline(in, line)) {
+    lineno++;
+    std::istringstream ls(line);
+    BatchEntryTy e;
+    std::string rest;
+    if (!(ls >> e.moduleFname)) {
+      continue; // empty line
+    }
+    if (!(ls >> e.outputFname) || (ls >> rest)) {
+      errs() << "ERROR: Invalid line " << lineno << " in batch file " << listFname << " (expected module and output file)\n";
+      return false;
+    }
+    entries.push_back(e);
+  }
+  return true;
+}
+
+void removeTemporaryCache(const std::string& dir) {
+
+  if (dir.empty()) {
+    return;
+  }
+  DIR *d = opendir(dir.c_str());
+  if (d) {
+    struct dirent *de;
+    while((de = readdir(d)) != NULL) {
+      std::string name = de->d_name;
+      if (name != "." && name != "..") {
+        unlink((dir + "/" + name).c_str());
+      }
+    }
+    closedir(d);
+  }
+  rmdir(dir.c_str());
+}
+
+std::string useTemporaryCache(Module *base, const std::string& baseFname) {
+
+  if (analysesCache.hasDir()) {
+    return std::string();
+  }
+  const char *tmpdir = getenv("TMPDIR");
+  std::string templ = std::string(tmpdir ? tmpdir : "/tmp") + "/rchk-cache-XXXXXX";
+  std::vector<char> buf(templ.begin(), templ.end());
+  buf.push_back(0);
+  if (!mkdtemp(buf.data())) {
+    errs() << "WARNING: cannot create temporary cache directory, analyses of the base will not be shared\n";
+    return std::string();
+  }
+  std::string dir = buf.data();
+  analysesCache.setDir(dir);
+  analysesCache.setBase(base, baseFname);
+  return dir;
+}
+
+pid_t forkForModule(const std::string& outputFname) {
+
+  analysesCache.reload(); // the child gets the analyses stored by previous checks in memory
+  outs().flush();
+  errs().flush();
+  
+  pid_t pid = fork();
+  if (pid != 0) {
+    return pid;
+  }
+  int fd = open(outputFname.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+  if (fd == -1) {
+    errs() << "ERROR: Cannot write output file " << outputFname << "\n";
+    exit(1);
+  }
+  dup2(fd, 1);
+  dup2(fd, 2);
+  close(fd);
+  return 0;
+}
+
+void runBatch(Module *base, const std::string& baseFname, std::string& moduleFname) {
+
+  BatchEntriesTy entries;
+  if (!readBatchFile(batchOptions.listFname, entries)) {
+    exit(1);
+  }
+
+  std::string tmpCacheDir = useTemporaryCache(base, baseFname);
+
+  unsigned nFailed = 0;
+  for(BatchEntriesTy::iterator ei = entries.begin(), ee = entries.end(); ei != ee; ++ei) {
+    BatchEntryTy& e = *ei;
+
+    pid_t pid = forkForModule(e.outputFname);
+    if (pid == -1) {
+      errs() << "ERROR: Cannot fork to check module " << e.moduleFname << "\n";
+      nFailed++;
+      continue;
+    }
+    if (pid == 0) {
+      moduleFname = e.moduleFname;
+      return;
+    }
+
+    int status;
+    if (waitpid(pid, &status, 0) == -1) {
+      errs() << "ERROR: Cannot wait for checking module " << e.moduleFname << "\n";
+      nFailed++;
+      continue;
+    }
+    if (WIFSIGNALED(status)) {
+      errs() << "ERROR: Checking module " << e.moduleFname << " failed (signal " << WTERMSIG(status) << "), see " << e.outputFname << "\n";
+      nFailed++;
+    } else if (WEXITSTATUS(status) != 0) {
+      errs() << "ERROR: Checking module " << e.moduleFname << " failed (exit status " << WEXITSTATUS(status) << "), see " << e.outputFname << "\n";
+      nFailed++;
+    }
+  }
+
+  removeTemporaryCache(tmpCacheDir);
+  exit(nFailed ? 1 : 0);
+}
@@ -0,0 +1,45 @@
+#ifndef RCHK_BATCH_H
+#define RCHK_BATCH_H
+
+#include <string>
+
+#include <sys/types.h>
+
+#include <llvm/IR/Module.h>
+
+using namespace llvm;
+
+// checking many package modules against one base module in a single run
+//   it is enabled using command line option of all tools (but fficheck)
+//     --batch FILE    each line of FILE gives a module and the file for its output
+//
+//   the base module is read once; each module is then linked and checked in a
+//   forked process, which gets its own copy of the base module (pages are only
+//   copied when linking modifies them) and has its output redirected to the file
+//
+//   the analyses of the base module are shared through the analyses cache
+//   (see cache.h); without --cache-dir, a temporary cache directory is used for
+//   the run, so only the first module pays for analyzing the base
+
+struct BatchOptionsTy {
+  std::string listFname; // empty means no batch mode
+
+  BatchOptionsTy(): listFname() {};
+  bool enabled() const { return !listFname.empty(); }
+};
+
+extern BatchOptionsTy batchOptions;
+
+bool extractBatchOptions(int& argc, char* argv[]); // false on invalid options
+
+// returns only in the forked process for a module, with moduleFname set
+//   the calling process exits once all modules have been checked
+void runBatch(Module *base, const std::string& baseFname, std::string& moduleFname);
+
+// also used by the server (see server.h)
+
+std::string useTemporaryCache(Module *base, const std::string& baseFname); // the directory, empty when not used
+void removeTemporaryCache(const std::string& dir);
+pid_t forkForModule(const std::string& outputFname); // 0 in the child, which has its output redirected
+
+#endif
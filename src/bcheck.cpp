@@ -16,11 +16,20 @@
 
 #include "common.h"
 
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <functional>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <set>
-#include <stack>
+#include <thread>
+#include <type_traits>
 #include <unordered_set>
 #include <unordered_map>
+#include <utility>
 
 #include <llvm/IR/Module.h>
 #include <llvm/IR/LLVMContext.h>
@@ -30,6 +39,10 @@
 
 #include <llvm/Support/raw_ostream.h>
 
+#include "arena.h"
+#include "budget.h"
+#include "spill.h"
+#include "worklist.h"
 #include "errors.h"
 #include "callocators.h"
 #include "allocators.h"
@@ -38,8 +51,10 @@
 #include "guards.h"
 #include "linemsg.h"
 #include "symbols.h"
+#include "vectors.h"
 #include "exceptions.h"
 #include "liveness.h"
+#include "tools.h"
 
 using namespace llvm;
 
@@ -67,6 +82,22 @@ const bool FULL_COMPARISON = true;
   //   (some states will not be checked)
   //   yet there may be some speedups in some cases
 
+const bool MEMOIZE_BLOCKS = true;
+  // remember the effect of the (non-terminator) instructions of a basic block on the state,
+  //   and replay it when the block is visited again with the same relevant part of the state
+  //   (guards are only relevant to blocks that use them, so states differing only in
+  //   guards unused by a block do not need to be re-processed)
+
+const bool SPARSE_EXPLORATION = true;
+  // do not create states for basic blocks where no handler acts and that
+  //   unconditionally branch to another block, but pass the states directly
+  //   to the first block after such a chain
+
+const unsigned PARALLEL_EXPLORATION_MIN_BLOCKS = 100;
+  // with --function-jobs, explore the states of functions with at least this many
+  //   basic blocks in multiple threads (smaller functions are checked quickly, and
+  //   the synchronization would not pay off for them)
+
 const bool USE_ALLOCATOR_DETECTION = true;
   // use allocator detection to set SEXP guard variables to non-nill on allocation
   // this is optional, because it is not correct
@@ -87,10 +118,19 @@ const bool EXCLUDE_PROTECTION_FUNCTIONS = true;
 
 // -------------------------------- basic block state -----------------------------------
 
-const int MAX_STATES = BCHECK_MAX_STATES;        // maximum number of states visited per function
+const unsigned long MAX_STATES = 3000000;        // default maximum number of states visited per function (see --max-states)
+
+thread_local unsigned int nComparedEqual = 0;
+thread_local unsigned int nComparedDifferent = 0;
 
-unsigned int nComparedEqual = 0;
-unsigned int nComparedDifferent = 0;
+struct BcheckPackedStateTy;
+
+// states being processed (unpacked), allocated by each thread from its arena
+//   they are short-lived: a state is deleted once it has been added to the done set
+//   (packed) or found to be a duplicate (see add), so the memory of one is soon reused
+//   for the next one; this arena is never reset
+
+thread_local Arena stateArena;
 
 struct BcheckStateTy : public StateWithGuardsTy, StateWithFreshVarsTy, StateWithBalanceTy {
   
@@ -102,11 +142,18 @@ struct BcheckStateTy : public StateWithGuardsTy, StateWithFreshVarsTy, StateWith
     BcheckStateTy(BasicBlock *bb, BalanceStateTy& balance, IntGuardsTy& intGuards, SEXPGuardsTy& sexpGuards, FreshVarsTy& freshVars):
       StateBaseTy(bb), StateWithGuardsTy(bb, intGuards, sexpGuards), StateWithFreshVarsTy(bb, freshVars), StateWithBalanceTy(bb, balance), hashcode(0) {};
       
+    BcheckStateTy(const BcheckPackedStateTy& ps, IntGuardsChecker& intGuardsChecker, SEXPGuardsChecker& sexpGuardsChecker);
+      
     virtual BcheckStateTy* clone(BasicBlock *newBB) {
       return new BcheckStateTy(newBB, balance, intGuards, sexpGuards, freshVars);
     }
+
+    static void* operator new(size_t size) { return stateArena.allocate(size); }
+    static void operator delete(void *p, size_t size) { stateArena.deallocate(p, size); }
     
     virtual bool add();
+    void widen(); // approximate checking, see --widen
+
     void hash() {
       size_t res = 0;
       hash_combine(res, bb);
@@ -115,49 +162,12 @@ struct BcheckStateTy : public StateWithGuardsTy, StateWithFreshVarsTy, StateWith
       hash_combine(res, balance.savedDepth);
       // not including topSaveVar
       hash_combine(res, (int) balance.countState);
-      hash_combine(res, intGuards.size());
-      for(IntGuardsTy::const_iterator gi = intGuards.begin(), ge = intGuards.end(); gi != ge; ++gi) {
-        AllocaInst* var = gi->first;
-        IntGuardState s = gi->second;
-        hash_combine(res, (void *)var);
-        hash_combine(res, (char) s);
-      } // ordered map
-
-      hash_combine(res, sexpGuards.size());
-      for(SEXPGuardsTy::const_iterator gi = sexpGuards.begin(), ge = sexpGuards.end(); gi != ge; ++gi) {
-        AllocaInst* var = gi->first;
-        const SEXPGuardTy& g = gi->second;
-        hash_combine(res, (void *) var);
-        hash_combine(res, (char) g.state);
-        if (g.state == SGS_SYMBOL) {
-          hash_combine(res, g.symbolName);
-        }
-      } // ordered map
-
-      hash_combine(res, freshVars.vars.size());
-      for(FreshVarsVarsTy::iterator fi = freshVars.vars.begin(), fe = freshVars.vars.end(); fi != fe; ++fi) {
-        AllocaInst* in = fi->first;
-        int pcount = fi->second;
-        hash_combine(res, (void *) in);
-        hash_combine(res, pcount);
-      } // ordered set
-
-      hash_combine(res, freshVars.condMsgs.size());
-      for(ConditionalMessagesTy::iterator mi = freshVars.condMsgs.begin(), me = freshVars.condMsgs.end(); mi != me; ++mi) {
-        DelayedLineMessenger& msg = mi->second;
-        hash_combine(res, msg.size());
-        
-        for(LineInfoPtrSetTy::const_iterator li = msg.delayedLineBuffer.begin(), le = msg.delayedLineBuffer.end(); li != le; ++li) {
-          const LineInfoTy* l = *li;
-          hash_combine(res, (const void *) l);
-        }
-      } // condMsgs is unordered
-
-      hash_combine(res, freshVars.pstack.size());
-      for(VarsVectorTy::iterator vi = freshVars.pstack.begin(), ve = freshVars.pstack.end(); vi != ve; ++vi) {
-        AllocaInst* var = *vi;
-        hash_combine(res, (void *) var);
-      }
+      // the components maintain their hashes incrementally as they are modified
+      hash_combine(res, intGuards.hash());
+      hash_combine(res, sexpGuards.hash());
+      hash_combine(res, freshVars.vars.hash());
+      hash_combine(res, freshVars.condMsgs.hash());
+      hash_combine(res, freshVars.pstack.hash());
       hashcode = res;
     }
 
@@ -174,35 +184,94 @@ struct BcheckStateTy : public StateWithGuardsTy, StateWithFreshVarsTy, StateWith
 
 };
 
-// the hashcode is cached at the time of first hashing
-//   (and indeed is not copied)
+// packed representation of a state, as stored in the done set
+//   guards are packed into bit vectors, and these as well as the fresh variables,
+//   protect stack and conditional messages are interned (they tend to be shared
+//   by many states), so that comparing states only compares pointers
+//
+//   the conditional messages all refer to the line messenger of the function being
+//   checked, so they can be interned as they are
+
+template <class T> struct SharedContainer_hash {
+  size_t operator()(const T& t) const {
+    return t.hash(); // maintained incrementally
+  }
+};
+
+typedef InterningTable<FreshVarsVarsTy, SharedContainer_hash<FreshVarsVarsTy>> FreshVarsVarsTableTy;
+typedef InterningTable<VarsVectorTy, SharedContainer_hash<VarsVectorTy>> VarsVectorTableTy;
+typedef InterningTable<ConditionalMessagesTy, SharedContainer_hash<ConditionalMessagesTy>> ConditionalMessagesTableTy;
+typedef InterningTable<PackedIntGuardsTy, PackedIntGuardsTy_hash> PackedIntGuardsTableTy;
+typedef InterningTable<PackedSEXPGuardsTy, PackedSEXPGuardsTy_hash> PackedSEXPGuardsTableTy;
+
+thread_local FreshVarsVarsTableTy varsTable; // FIXME: avoid these globals
+thread_local VarsVectorTableTy pstackTable;
+thread_local ConditionalMessagesTableTy condMsgsTable;
+thread_local PackedIntGuardsTableTy intGuardsTable;
+thread_local PackedSEXPGuardsTableTy sexpGuardsTable;
+
+struct BcheckPackedStateTy : public PackedStateWithGuardsTy {
+  const size_t hashcode;
+  const BalanceStateTy balance;
+  const FreshVarsVarsTy *vars;
+  const VarsVectorTy *pstack;
+  const ConditionalMessagesTy *condMsgs;
+  const bool confused; // of fresh variables
+  
+  BcheckPackedStateTy(size_t hashcode, BasicBlock *bb, const BalanceStateTy& balance, const PackedIntGuardsTy *intGuards, const PackedSEXPGuardsTy *sexpGuards,
+    const FreshVarsVarsTy *vars, const VarsVectorTy *pstack, const ConditionalMessagesTy *condMsgs, bool confused):
+    
+    PackedStateBaseTy(bb), PackedStateWithGuardsTy(bb, intGuards, sexpGuards), hashcode(hashcode), balance(balance),
+    vars(vars), pstack(pstack), condMsgs(condMsgs), confused(confused) {};
+    
+  static BcheckPackedStateTy create(BcheckStateTy& us, IntGuardsChecker& intGuardsChecker, SEXPGuardsChecker& sexpGuardsChecker);
+};
+
+BcheckPackedStateTy BcheckPackedStateTy::create(BcheckStateTy& us, IntGuardsChecker& intGuardsChecker, SEXPGuardsChecker& sexpGuardsChecker) {
+
+  return BcheckPackedStateTy(us.hashcode, us.bb, us.balance, intGuardsTable.intern(intGuardsChecker.pack(us.intGuards)), sexpGuardsTable.intern(sexpGuardsChecker.pack(us.sexpGuards)),
+    varsTable.intern(us.freshVars.vars), pstackTable.intern(us.freshVars.pstack), condMsgsTable.intern(us.freshVars.condMsgs), us.freshVars.confused);
+}
+
+static FreshVarsTy unpackFreshVars(const BcheckPackedStateTy& ps) {
+
+  FreshVarsTy freshVars;
+  freshVars.vars = *ps.vars; // shared
+  freshVars.pstack = *ps.pstack;
+  freshVars.condMsgs = *ps.condMsgs;
+  freshVars.confused = ps.confused;
+  return freshVars;
+}
+
+BcheckStateTy::BcheckStateTy(const BcheckPackedStateTy& ps, IntGuardsChecker& intGuardsChecker, SEXPGuardsChecker& sexpGuardsChecker):
+  StateBaseTy(ps.bb), StateWithGuardsTy(ps.bb, intGuardsChecker.unpack(*ps.intGuards), sexpGuardsChecker.unpack(*ps.sexpGuards)),
+  StateWithFreshVarsTy(ps.bb, unpackFreshVars(ps)), StateWithBalanceTy(ps.bb, ps.balance), hashcode(ps.hashcode) {};
 
-struct BcheckStateTy_hash {
-  size_t operator()(const BcheckStateTy* t) const {
-    return t->hashcode;
+// the hashcode is computed from the unpacked state when adding it
+
+struct BcheckPackedStateTy_hash {
+  size_t operator()(const BcheckPackedStateTy& t) const {
+    return t.hashcode;
   }
 };
 
-struct BcheckStateTy_equal {
-  bool operator() (const BcheckStateTy* lhs, const BcheckStateTy* rhs) const {
+struct BcheckPackedStateTy_equal {
+  bool operator() (const BcheckPackedStateTy& lhs, const BcheckPackedStateTy& rhs) const {
 
     if (!FULL_COMPARISON) {
-      return lhs->hashcode == rhs->hashcode;
+      return lhs.hashcode == rhs.hashcode;
       // we could just return true, because the map will not call this for objects with
       // different hashcodes
     }
     
     bool res;
-    if (lhs == rhs) {
+    if (&lhs == &rhs) {
       res = true;
     } else {
-      res = lhs->bb == rhs->bb && 
-      lhs->balance.depth == rhs->balance.depth && lhs->balance.savedDepth == rhs->balance.savedDepth && lhs->balance.count == rhs->balance.count &&
-      lhs->balance.countState == rhs->balance.countState && lhs->balance.counterVar == rhs->balance.counterVar && lhs->balance.confused == rhs->balance.confused &&
-      lhs->balance.topSaveVar == rhs->balance.topSaveVar &&
-      lhs->intGuards == rhs->intGuards && lhs->sexpGuards == rhs->sexpGuards &&
-      lhs->freshVars.vars == rhs->freshVars.vars && lhs->freshVars.condMsgs == rhs->freshVars.condMsgs && lhs->freshVars.pstack == rhs->freshVars.pstack
-         && lhs->freshVars.confused == rhs->freshVars.confused;
+      res = lhs.bb == rhs.bb && lhs.balance == rhs.balance &&
+      lhs.intGuards == rhs.intGuards && lhs.sexpGuards == rhs.sexpGuards &&
+      lhs.vars == rhs.vars && lhs.condMsgs == rhs.condMsgs && lhs.pstack == rhs.pstack // interned
+         && lhs.confused == rhs.confused;
     }
     
     if (PROGRESS_MARKS) {
@@ -216,44 +285,508 @@ struct BcheckStateTy_equal {
   }
 };
 
-typedef std::stack<BcheckStateTy*> WorkListTy;
-typedef std::unordered_set<BcheckStateTy*, BcheckStateTy_hash, BcheckStateTy_equal> DoneSetTy;
+// a packed state spilled to disk (see spill.h)
+
+struct BcheckSpilledStateTy {
+  BasicBlock *bb;
+  AllocaInst *counterVar;
+  AllocaInst *topSaveVar;
+  const PackedIntGuardsTy *intGuards;
+  const PackedSEXPGuardsTy *sexpGuards;
+  const FreshVarsVarsTy *vars;
+  const VarsVectorTy *pstack;
+  const ConditionalMessagesTy *condMsgs;
+  int depth;
+  int savedDepth;
+  int count;
+  int countState;
+  bool balanceConfused;
+  bool confused;
+};
+
+static void spillRecord(const BcheckPackedStateTy& ps, BcheckSpilledStateTy& record) {
+
+  memset(&record, 0, sizeof(record)); // records are compared including the padding
+  record.bb = ps.bb;
+  record.counterVar = ps.balance.counterVar;
+  record.topSaveVar = ps.balance.topSaveVar;
+  record.intGuards = ps.intGuards;
+  record.sexpGuards = ps.sexpGuards;
+  record.vars = ps.vars;
+  record.pstack = ps.pstack;
+  record.condMsgs = ps.condMsgs;
+  record.depth = ps.balance.depth;
+  record.savedDepth = ps.balance.savedDepth;
+  record.count = ps.balance.count;
+  record.countState = ps.balance.countState;
+  record.balanceConfused = ps.balance.confused;
+  record.confused = ps.confused;
+}
+
+typedef StateWorkListTy<const BcheckPackedStateTy*> WorkListTy;
+typedef ArenaAllocator<BcheckPackedStateTy> DoneSetAllocatorTy;
+typedef std::unordered_set<BcheckPackedStateTy, BcheckPackedStateTy_hash, BcheckPackedStateTy_equal, DoneSetAllocatorTy> DoneSetTy;
+
+static_assert(std::is_trivially_destructible<BcheckPackedStateTy>::value, "the done set is released with its arena, without destroying the states");
 
 // ------------- helper functions --------------
 
-DoneSetTy doneSet;
-WorkListTy workList;   
+// with --jobs, each worker thread checks different functions, and hence
+// needs its own exploration state
+
+thread_local Arena doneSetArena; // nodes and buckets of the done set, released at once by clearStates
+thread_local DoneSetTy doneSet(0, BcheckPackedStateTy_hash(), BcheckPackedStateTy_equal(), DoneSetAllocatorTy(&doneSetArena));
+thread_local WorkListTy workList;   
+thread_local SpilledStatesTy spilledStates(sizeof(BcheckSpilledStateTy)); // explored states moved out of the done set
+
+thread_local IntGuardsChecker* packingIntGuardsChecker; // of the function being checked, FIXME: avoid these globals
+thread_local SEXPGuardsChecker* packingSEXPGuardsChecker;
+
+typedef std::unordered_map<BasicBlock*, BasicBlock*> SparseSuccessorsTy; // skipped block -> first block not skipped
+thread_local SparseSuccessorsTy* sparseSuccessors; // of the function being checked
+
+// approximate checking (--widen K)
+//   at merge points, guards that are dead (not read before being overwritten) are dropped,
+//   so that states differing only in them are joined; once K states have reached a block,
+//   all guards of further states reaching it are widened to unknown (IGS_UNKNOWN, SGS_UNKNOWN)
+//
+//   this bounds the number of guard combinations explored per block, but loses precision
+//   (there may be more false alarms)
+
+unsigned long widenLimit = 0; // states per block, 0 means no widening (precise checking)
+
+typedef std::unordered_map<BasicBlock*, std::vector<AllocaInst*>> BlockVarsTy;
+thread_local BlockVarsTy* deadGuardsAtMerges; // of the function being checked
+thread_local std::unordered_map<BasicBlock*, unsigned long> statesPerBlock;
+
+void BcheckStateTy::widen() {
+  auto dsearch = deadGuardsAtMerges->find(bb);
+  if (dsearch != deadGuardsAtMerges->end()) {
+    for(std::vector<AllocaInst*>::const_iterator vi = dsearch->second.begin(), ve = dsearch->second.end(); vi != ve; ++vi) {
+      intGuards.erase(*vi);
+      sexpGuards.erase(*vi);
+    }
+  }
+  auto nsearch = statesPerBlock.find(bb);
+  if (nsearch != statesPerBlock.end() && nsearch->second >= widenLimit) {
+    intGuards.clear();
+    sexpGuards.clear();
+  }
+}
+
+// exploration of the states of a single function by multiple threads (--function-jobs N)
+//   each thread has its own worklist and takes states from the worklists of other
+//   threads when its own is empty (work stealing)
+//
+//   the done set is split into shards with their own locks; the components of
+//   packed states are interned in tables shared by all threads, so that the
+//   states can still be compared by pointers and exact duplicates are found
+//
+//   the threads are taken from a pool created once per run, which explores one
+//   function at a time (with --jobs, other large functions checked meanwhile are
+//   explored in a single thread); the memoized block transfers are shared by the
+//   threads and kept across restarts, like with a single thread
+//
+//   spilling (--spill-dir) is not supported, and the done set shards are filled by
+//   several threads, so they are allocated normally rather than from an arena
+//
+//   the set of explored states does not depend on the order in which they are
+//   explored, so the messages (printed ordered) are the same as with exploring in
+//   a single thread, unless checking has to be restarted or the budget is exceeded,
+//   and then the messages are dropped anyway
+
+unsigned long nFunctionJobs = 1; // threads exploring a single function
+
+// threads running the same task, waiting between tasks
+class ExplorationPoolTy {
+
+  std::vector<std::thread> threads;
+  std::mutex mutex; // protects the fields below
+  std::condition_variable started;
+  std::condition_variable finished;
+  std::function<void(unsigned)> task; // gets the index of the thread
+  unsigned long generation; // of the task
+  unsigned nRunning;
+  bool stopping;
+
+  void worker(unsigned thread) {
+    unsigned long done = 0; // generation
+    for(;;) {
+      std::function<void(unsigned)> t;
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        started.wait(lock, [this, done]() { return stopping || generation != done; });
+        if (stopping) {
+          return;
+        }
+        done = generation;
+        t = task;
+      }
+      t(thread);
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        nRunning--;
+      }
+      finished.notify_all();
+    }
+  }
+
+  public:
+    std::mutex busy; // held by the thread using the pool
+
+    ExplorationPoolTy(unsigned nThreads): threads(), mutex(), started(), finished(), task(), generation(0), nRunning(0), stopping(false), busy() {
+      for(unsigned i = 0; i < nThreads; i++) {
+        threads.push_back(std::thread(&ExplorationPoolTy::worker, this, i));
+      }
+    }
+
+    ~ExplorationPoolTy() {
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+      }
+      started.notify_all();
+      for(std::vector<std::thread>::iterator ti = threads.begin(), te = threads.end(); ti != te; ++ti) {
+        ti->join();
+      }
+    }
+
+    // runs the task in all threads, returns when they have all finished it
+    void run(const std::function<void(unsigned)>& t) {
+      std::unique_lock<std::mutex> lock(mutex);
+      task = t;
+      nRunning = threads.size();
+      generation++;
+      started.notify_all();
+      finished.wait(lock, [this]() { return nRunning == 0; });
+    }
+};
+
+ExplorationPoolTy* explorationPool = NULL; // with --function-jobs, for the duration of runBcheck
+
+struct ConcurrentBlockTransfersTy; // see block transfer memoization
+
+typedef std::unordered_set<BcheckPackedStateTy, BcheckPackedStateTy_hash, BcheckPackedStateTy_equal> ConcurrentDoneSetShardTy;
+
+struct ParallelExplorationTy {
+
+  static const unsigned NSHARDS = 64;
+
+  struct DoneSetShardTy {
+    std::mutex mutex;
+    ConcurrentDoneSetShardTy states;
+  };
+
+  struct ThreadWorkListTy {
+    std::mutex mutex;
+    std::deque<const BcheckPackedStateTy*> states; // the owner takes from the back, others steal from the front
+  };
+
+  ConcurrentInterningTable<FreshVarsVarsTy, SharedContainer_hash<FreshVarsVarsTy>> varsTable;
+  ConcurrentInterningTable<VarsVectorTy, SharedContainer_hash<VarsVectorTy>> pstackTable;
+  ConcurrentInterningTable<ConditionalMessagesTy, SharedContainer_hash<ConditionalMessagesTy>> condMsgsTable;
+  ConcurrentInterningTable<PackedIntGuardsTy, PackedIntGuardsTy_hash> intGuardsTable;
+  ConcurrentInterningTable<PackedSEXPGuardsTy, PackedSEXPGuardsTy_hash> sexpGuardsTable;
+
+  DoneSetShardTy doneSet[NSHARDS]; // refers to the interned components
+  std::vector<ThreadWorkListTy> workLists; // one per thread
+
+  std::atomic<unsigned long> nStates; // in the done set
+  std::atomic<unsigned long> nPending; // added, but not yet fully processed
+  std::atomic<unsigned long> nAvailable; // in the work lists
+  std::atomic<unsigned long> maxAvailable;
+  std::atomic<bool> stopped; // some thread found a refinable info (restartable) or exceeded the budget
+
+  std::mutex idleMutex; // for threads waiting for states
+  std::condition_variable idleCondition;
+  std::atomic<unsigned> nIdle; // threads waiting for states
+
+  ConcurrentBlockTransfersTy* blockTransfers; // of the checking thread, shared by the threads
+
+  std::mutex resultMutex; // protects the fields below
+  unsigned refinableInfos;
+  std::string budgetExceededReason; // empty when not exceeded
+
+  ParallelExplorationTy(unsigned nThreads, ConcurrentBlockTransfersTy* blockTransfers): workLists(nThreads), nStates(0), nPending(0), nAvailable(0),
+    maxAvailable(0), stopped(false), idleMutex(), idleCondition(), nIdle(0), blockTransfers(blockTransfers), refinableInfos(0), budgetExceededReason() {};
+
+  bool add(BcheckStateTy& s, unsigned thread);
+  const BcheckPackedStateTy* take(unsigned thread); // NULL when no state is available at the moment
+
+  // waits until a state is available, all states have been processed or the exploration stopped
+  void waitForStates() {
+    std::unique_lock<std::mutex> lock(idleMutex);
+    nIdle++;
+    idleCondition.wait(lock, [this]() { return nAvailable > 0 || nPending == 0 || stopped; });
+    nIdle--;
+  }
+
+  // wakes up the waiting threads, e.g. when the last pending state has been processed
+  void wakeUpAll() {
+    {
+      std::lock_guard<std::mutex> lock(idleMutex);
+    }
+    idleCondition.notify_all();
+  }
+
+  void finished(unsigned threadRefinableInfos, const std::string& threadBudgetExceededReason) {
+    std::lock_guard<std::mutex> lock(resultMutex);
+    refinableInfos += threadRefinableInfos;
+    if (budgetExceededReason.empty()) {
+      budgetExceededReason = threadBudgetExceededReason;
+    }
+  }
+};
+
+thread_local ParallelExplorationTy* parallelExploration = NULL; // when the current thread explores a function in parallel
+thread_local unsigned parallelThread; // index of the current thread in the parallel exploration
+
+bool ParallelExplorationTy::add(BcheckStateTy& s, unsigned thread) {
+
+  BcheckPackedStateTy ps(s.hashcode, s.bb, s.balance,
+    intGuardsTable.intern(packingIntGuardsChecker->pack(s.intGuards)), sexpGuardsTable.intern(packingSEXPGuardsChecker->pack(s.sexpGuards)),
+    varsTable.intern(s.freshVars.vars), pstackTable.intern(s.freshVars.pstack), condMsgsTable.intern(s.freshVars.condMsgs), s.freshVars.confused);
+
+  DoneSetShardTy& shard = doneSet[mix_hash(s.hashcode) % NSHARDS];
+  const BcheckPackedStateTy* added;
+  {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto sinsert = shard.states.insert(ps);
+    if (!sinsert.second) {
+      return false;
+    }
+    added = &*sinsert.first;
+  }
+  nStates++;
+  nPending++;
+
+  ThreadWorkListTy& wl = workLists.at(thread);
+  unsigned long available;
+  {
+    std::lock_guard<std::mutex> lock(wl.mutex);
+    wl.states.push_back(added);
+    available = ++nAvailable; // under the lock, so that take() does not decrement it first
+  }
+  unsigned long max = maxAvailable;
+  while(available > max && !maxAvailable.compare_exchange_weak(max, available));
+  if (nIdle > 0) {
+    // a thread that is going to wait increments nIdle before checking nAvailable
+    {
+      std::lock_guard<std::mutex> lock(idleMutex);
+    }
+    idleCondition.notify_one();
+  }
+  return true;
+}
+
+const BcheckPackedStateTy* ParallelExplorationTy::take(unsigned thread) {
+
+  unsigned nThreads = workLists.size();
+  for(unsigned i = 0; i < nThreads; i++) {
+    ThreadWorkListTy& wl = workLists[(thread + i) % nThreads];
+    std::lock_guard<std::mutex> lock(wl.mutex);
+    if (wl.states.empty()) {
+      continue;
+    }
+    const BcheckPackedStateTy* ps;
+    if (i == 0) {
+      ps = wl.states.back();
+      wl.states.pop_back();
+    } else {
+      ps = wl.states.front(); // steal a state found early, likely with more work behind it
+      wl.states.pop_front();
+    }
+    nAvailable--;
+    return ps;
+  }
+  return NULL;
+}
 
 bool BcheckStateTy::add() {
+  if (SPARSE_EXPLORATION) {
+    auto ssearch = sparseSuccessors->find(bb);
+    if (ssearch != sparseSuccessors->end()) {
+      bb = ssearch->second;
+    }
+  }
+  if (widenLimit) {
+    widen();
+  }
   hash(); // precompute hashcode
-  auto sinsert = doneSet.insert(this);
+  if (parallelExploration) {
+    bool added = parallelExploration->add(*this, parallelThread);
+    delete this; // NOTE: state suicide
+    return added;
+  }
+  BcheckPackedStateTy ps = BcheckPackedStateTy::create(*this, *packingIntGuardsChecker, *packingSEXPGuardsChecker);
+  if (spilledStates.size()) {
+    BcheckSpilledStateTy record;
+    spillRecord(ps, record);
+    if (spilledStates.contains(hashcode, &record)) {
+      delete this; // NOTE: state suicide
+      return false;
+    }
+  }
+  auto sinsert = doneSet.insert(ps);
   if (sinsert.second) {
-    workList.push(this);
+    workList.push(&*sinsert.first); // make the worklist point to the doneset
+    if (widenLimit) {
+      statesPerBlock[bb]++;
+    }
     if (DUMP_STATES && (DUMP_STATES_FUNCTION.empty() || DUMP_STATES_FUNCTION == bb->getParent()->getName())) {
       outs().flush();
       errs() << "\n -- dumping a new state being added -- \n";
-      workList.top()->dump();
+      dump();
+    }
+    if (spilledStates.shouldSpill(doneSet.size())) {
+      spilledStates.spill<BcheckSpilledStateTy>(doneSet, workList, spillRecord);
     }
-    return true;
-  } else {
-    delete this; // NOTE: state suicide
-    return false;
   }
+  delete this; // NOTE: state suicide
+  return sinsert.second;
 }
 
-unsigned long totalStates = 0;
+// checks enabled when exploring the states of a function
+//   the exploration is specialized at compile time for each combination, so that
+//   the handlers of disabled checks are not even tested for at each instruction
+
+enum CheckFlags {
+  CK_BALANCE = 1,
+  CK_FRESHVARS = 2,
+  CK_INTGUARDS = 4,
+  CK_SEXPGUARDS = 8,
+  CK_RESTARTABLE = 16 // restart on the first refinable info
+};
+
+// ------------- block transfer memoization --------------
+
+// the effect of the non-terminator instructions of a basic block, for a given
+// relevant part of the input state
+//   guards not used by the block are not part of the key and pass through
+//   the block unchanged
+//
+//   the checks enabled for the block are part of the key, so that the
+//   transfers are kept when checking of a function is restarted with more
+//   precise guards: blocks not using the newly enabled guards are not
+//   processed again (most blocks do not use guards)
+//
+//   the recorded messages are interned in the line messenger of the
+//   function being checked, so the memoized transfers have to be cleared
+//   before checking the next function
+
+struct BlockTransferKeyTy {
+  BasicBlock *bb;
+  unsigned checks; // CheckFlags, guards only when used by the block, not restartable
+  BalanceStateTy balance;
+  FreshVarsTy freshVars;
+  IntGuardsTy intGuards; // empty when not used by the block
+  SEXPGuardsTy sexpGuards; // empty when not used by the block
+  size_t hashcode;
+
+  BlockTransferKeyTy(BcheckStateTy& s, unsigned checks):
+    bb(s.bb), checks(checks), balance(s.balance), freshVars(s.freshVars), intGuards(), sexpGuards(), hashcode(0) {
+
+    if (checks & CK_INTGUARDS) {
+      intGuards = s.intGuards;
+    }
+    if (checks & CK_SEXPGUARDS) {
+      sexpGuards = s.sexpGuards;
+    }
+    hash_combine(hashcode, bb);
+    hash_combine(hashcode, checks);
+    hash_combine(hashcode, balance.depth);
+    hash_combine(hashcode, balance.count);
+    hash_combine(hashcode, balance.savedDepth);
+    hash_combine(hashcode, (int) balance.countState);
+    hash_combine(hashcode, intGuards.hash());
+    hash_combine(hashcode, sexpGuards.hash());
+    hash_combine(hashcode, freshVars.vars.hash());
+    hash_combine(hashcode, freshVars.condMsgs.hash());
+    hash_combine(hashcode, freshVars.pstack.hash());
+  }
+};
+
+struct BlockTransferKeyTy_hash {
+  size_t operator()(const BlockTransferKeyTy& t) const {
+    return t.hashcode;
+  }
+};
+
+struct BlockTransferKeyTy_equal {
+  bool operator() (const BlockTransferKeyTy& lhs, const BlockTransferKeyTy& rhs) const {
+    return lhs.bb == rhs.bb && lhs.checks == rhs.checks && lhs.balance == rhs.balance && lhs.intGuards == rhs.intGuards && lhs.sexpGuards == rhs.sexpGuards &&
+      lhs.freshVars == rhs.freshVars;
+  }
+};
+
+struct BlockTransferTy {
+  BalanceStateTy balance;
+  FreshVarsTy freshVars;
+  IntGuardsTy intGuards; // only valid when used by the block
+  SEXPGuardsTy sexpGuards; // only valid when used by the block
+  LineInfoPtrVectorTy messages; // emitted while processing the block
+  unsigned refinableInfos; // found while processing the block
+
+  BlockTransferTy(BcheckStateTy& s, LineInfoPtrVectorTy& messages, unsigned refinableInfos):
+    balance(s.balance), freshVars(s.freshVars), intGuards(s.intGuards), sexpGuards(s.sexpGuards), messages(messages), refinableInfos(refinableInfos) {};
+};
+
+typedef std::unordered_map<BlockTransferKeyTy, BlockTransferTy, BlockTransferKeyTy_hash, BlockTransferKeyTy_equal> BlockTransfersTy;
+
+thread_local BlockTransfersTy blockTransfers;
+
+// memoized block transfers shared by the threads of a parallel exploration
+struct ConcurrentBlockTransfersTy {
+
+  static const unsigned NSHARDS = 64;
+
+  struct ShardTy {
+    std::mutex mutex;
+    BlockTransfersTy transfers;
+  };
+
+  ShardTy shards[NSHARDS];
+
+  ShardTy& shard(const BlockTransferKeyTy& key) { return shards[mix_hash(key.hashcode) % NSHARDS]; }
+
+  void clear() {
+    for(unsigned i = 0; i < NSHARDS; i++) {
+      std::lock_guard<std::mutex> lock(shards[i].mutex);
+      BlockTransfersTy empty; // also releases the buckets
+      std::swap(shards[i].transfers, empty);
+    }
+  }
+};
+
+thread_local ConcurrentBlockTransfersTy concurrentBlockTransfers; // used by the threads exploring a function of this thread
+thread_local size_t maxParallelPending = 0; // in the work lists of parallel explorations
+
+thread_local unsigned long totalStates = 0;
 
 void clearStates() {
   // clear the worklist and the doneset
-  totalStates += doneSet.size();
-  for(DoneSetTy::iterator ds = doneSet.begin(), de = doneSet.end(); ds != de; ++ds) {
-    BcheckStateTy *old = *ds;
-    delete old;
-  }
-  doneSet.clear();
-  WorkListTy empty;
-  std::swap(workList, empty);
-  // all elements in worklist are also in doneset, so no need to call destructors
+  totalStates += doneSet.size() + spilledStates.size();
+  spilledStates.clear();
+  // the done set is abandoned rather than destroyed, so releasing it does not
+  //   depend on the number of states (the packed states only refer to the interned
+  //   components, which are owned by the interning tables)
+  doneSetArena.reset();
+  new (&doneSet) DoneSetTy(0, BcheckPackedStateTy_hash(), BcheckPackedStateTy_equal(), DoneSetAllocatorTy(&doneSetArena));
+  workList.clear();
+  statesPerBlock.clear();
+  varsTable.clear();
+  pstackTable.clear();
+  condMsgsTable.clear();
+  intGuardsTable.clear();
+  sexpGuardsTable.clear();
+}
+
+void clearBlockTransfers() {
+  BlockTransfersTy empty; // also releases the buckets
+  std::swap(blockTransfers, empty);
+  if (nFunctionJobs > 1) {
+    concurrentBlockTransfers.clear();
+  }
 }
 
 void handleUnprotectWithIntGuard(Instruction *in, BcheckStateTy& s, GlobalsTy& g, IntGuardsChecker& intGuardsChecker, LineMessenger& msg, unsigned& refinableInfos) { 
@@ -331,10 +864,55 @@ struct ModuleCheckingStateTy {
   LineMessenger& msg;
   CalledModuleTy& cm;
   CProtectInfo& cprotect;
+  raw_ostream& err; // for errors not going through the messenger
   
   ModuleCheckingStateTy(FunctionsSetTy& possibleAllocators, FunctionsSetTy& allocatingFunctions, FunctionsSetTy& errorFunctions,
-      GlobalsTy& gl, LineMessenger& msg, CalledModuleTy& cm, CProtectInfo& cprotect):
-    possibleAllocators(possibleAllocators), allocatingFunctions(allocatingFunctions), errorFunctions(errorFunctions), gl(gl), msg(msg), cm(cm), cprotect(cprotect) {};
+      GlobalsTy& gl, LineMessenger& msg, CalledModuleTy& cm, CProtectInfo& cprotect, raw_ostream& err):
+    possibleAllocators(possibleAllocators), allocatingFunctions(allocatingFunctions), errorFunctions(errorFunctions), gl(gl), msg(msg), cm(cm), cprotect(cprotect), err(err) {};
+    
+  ModuleCheckingStateTy(ModuleCheckingStateTy& other, LineMessenger& msg, raw_ostream& err): // for a worker thread
+    ModuleCheckingStateTy(other.possibleAllocators, other.allocatingFunctions, other.errorFunctions, other.gl, msg, other.cm, other.cprotect, err) {};
+};
+
+// -------------------------------- pre-decoded blocks -----------------------------------
+
+// instructions of a basic block the handlers may act on, classified once per function,
+// so that the instructions irrelevant to the enabled checks are skipped when
+// visiting the block
+//   the handlers still interpret the instructions themselves, the classification
+//   is conservative
+
+enum InstructionEvents {
+  EV_FRESHVARS = 1, // call, load of a SEXP variable, store other than to a non-SEXP variable
+  EV_BALANCE = 2, // PROTECT/UNPROTECT call, load of R_PPStackTop, store to a protection counter or R_PPStackTop
+  EV_INTGUARDS = 4, // store to an int guard
+  EV_UNPROTECT = 8, // UNPROTECT call, possibly with an int guard
+  EV_SEXPGUARDS = 16, // store to a SEXP guard, vector-only operation on a variable
+  EV_ALL = 31
+};
+
+struct InstructionEventsTy {
+  Instruction *in;
+  unsigned events; // InstructionEvents
+};
+
+struct BlockEventsTy {
+  std::vector<InstructionEventsTy> instructions; // only those with some events
+  bool intGuardsUsed; // int guards may be read or modified by the block
+  bool sexpGuardsUsed; // SEXP guards may be read or modified by the block
+};
+
+// what is found about a function before exploring its states
+//   it is only read during the exploration, so the threads of a parallel
+//   exploration share it
+
+struct FunctionFactsTy {
+  BasicBlocksSetTy errorBasicBlocks;
+  LiveVarsTy liveVars;
+
+  std::unordered_map<BasicBlock*, BlockEventsTy> blockEvents; // of all blocks of the function
+  SparseSuccessorsTy sparseSuccessors;
+  BlockVarsTy deadGuardsAtMerges; // only with --widen
 };
 
 class FunctionChecker {
@@ -345,16 +923,424 @@ class FunctionChecker {
   VarBoolCacheTy checkedVarsCache;
   IntGuardsChecker intGuardsChecker;
   SEXPGuardsChecker sexpGuardsChecker;
-  BasicBlocksSetTy errorBasicBlocks;
-  LiveVarsTy liveVars;
+  std::shared_ptr<FunctionFactsTy> facts; // shared with the copies for threads
+  bool parallel; // explore states in multiple threads
 
   ModuleCheckingStateTy& m;
 
-  void checkFunction(bool intGuardsEnabled, bool sexpGuardsEnabled, bool balanceCheckingEnabled, bool freshVarsCheckingEnabled, unsigned& refinableInfos) {
+  // classifies the instructions of a block, done once per function
+  void decodeBlock(BasicBlock *bb, BlockEventsTy& be) {
+
+    be.intGuardsUsed = false;
+    be.sexpGuardsUsed = false;
+    for(BasicBlock::iterator ini = bb->begin(), ine = bb->end(); ini != ine; ++ini) {
+      Instruction *in = &*ini;
+      unsigned events = 0;
+
+      CallSite cs(cast<Value>(in));
+      if (cs) {
+        be.sexpGuardsUsed = true; // call contexts may depend on SEXP guards
+        Function *f = cs.getCalledFunction();
+        if (f) {
+          events |= EV_FRESHVARS;
+          if (f == m.gl.protectFunction || f == m.gl.protectWithIndexFunction || f == m.gl.unprotectFunction || f == m.gl.unprotectPtrFunction) {
+            events |= EV_BALANCE;
+          }
+          if (f == m.gl.unprotectFunction) {
+            events |= EV_UNPROTECT;
+            be.intGuardsUsed = true;
+          }
+        }
+      }
+      if (LoadInst *li = dyn_cast<LoadInst>(in)) {
+        Value *var = li->getPointerOperand();
+        if (var == m.gl.ppStackTopVariable) {
+          events |= EV_BALANCE;
+        }
+        if (AllocaInst::classof(var)) {
+          if (isSEXP(cast<AllocaInst>(var))) { // only SEXP variables can be fresh
+            events |= EV_FRESHVARS;
+          }
+          be.sexpGuardsUsed = be.sexpGuardsUsed || sexpGuardsChecker.isGuard(cast<AllocaInst>(var));
+        }
+        if (!li->user_empty() && CallSite(li->user_back())) {
+          be.sexpGuardsUsed = true;
+        }
+      }
+      if (StoreInst *si = dyn_cast<StoreInst>(in)) {
+        Value *var = si->getPointerOperand();
+        if (!AllocaInst::classof(var) || isSEXP(cast<AllocaInst>(var))) {
+          events |= EV_FRESHVARS;
+        }
+        if (var == m.gl.ppStackTopVariable ||
+            (AllocaInst::classof(var) && isProtectionCounterVariable(cast<AllocaInst>(var), m.gl.unprotectFunction, counterVarsCache))) {
+          events |= EV_BALANCE;
+        }
+        if (AllocaInst::classof(var)) {
+          if (intGuardsChecker.isGuard(cast<AllocaInst>(var))) { // int guards are only read at unprotect
+            events |= EV_INTGUARDS;
+            be.intGuardsUsed = true;
+          }
+          if (sexpGuardsChecker.isGuard(cast<AllocaInst>(var))) {
+            events |= EV_SEXPGUARDS;
+            be.sexpGuardsUsed = true;
+          }
+        }
+        if (CallSite(si->getValueOperand())) {
+          be.sexpGuardsUsed = true;
+        }
+      }
+      AllocaInst *vvar;
+      if (isVectorOnlyVarOperation(in, vvar)) {
+        events |= EV_SEXPGUARDS;
+        be.sexpGuardsUsed = true;
+      }
+      for(User::op_iterator oi = in->op_begin(), oe = in->op_end(); oi != oe; ++oi) { // e.g. bitcast of a loaded variable
+        if (LoadInst *li = dyn_cast<LoadInst>(*oi)) {
+          if (AllocaInst *ovar = dyn_cast<AllocaInst>(li->getPointerOperand())) {
+            be.sexpGuardsUsed = be.sexpGuardsUsed || sexpGuardsChecker.isGuard(ovar);
+          }
+        }
+      }
+
+      if (TRACE) {
+        events = EV_ALL; // so that all instructions are traced
+      }
+      if (events) {
+        InstructionEventsTy ie = { in, events };
+        be.instructions.push_back(ie);
+      }
+    }
+  }
+
+  // a block can be skipped when it has no events, it is not on an error path (states there
+  // are ignored), and it unconditionally branches to another block
+  bool isSkippable(BasicBlock *bb) {
+    if (!facts->blockEvents.at(bb).instructions.empty() || facts->errorBasicBlocks.find(bb) != facts->errorBasicBlocks.end()) {
+      return false;
+    }
+    BranchInst *br = dyn_cast<BranchInst>(bb->getTerminator());
+    return br && !br->isConditional();
+  }
+
+  void findSparseSuccessors() {
+    for(Function::iterator bi = fun->begin(), be = fun->end(); bi != be; ++bi) {
+      BasicBlock *bb = &*bi;
+      if (!isSkippable(bb)) {
+        continue;
+      }
+      BasicBlocksSetTy visited; // in case of a loop of skippable blocks
+      BasicBlock *succ = bb;
+      while(isSkippable(succ) && visited.insert(succ).second) {
+        succ = succ->getTerminator()->getSuccessor(0);
+      }
+      if (succ != bb) {
+        facts->sparseSuccessors.insert({bb, succ});
+      }
+    }
+  }
+
+  // guard variables not live at the start of blocks with multiple predecessors
+  //   (blocks not leading to a return have no liveness information)
+  void findDeadGuardsAtMerges() {
+    std::vector<AllocaInst*> guards;
+    for(BasicBlock::iterator ii = fun->getEntryBlock().begin(), ie = fun->getEntryBlock().end(); ii != ie; ++ii) {
+      if (AllocaInst *var = dyn_cast<AllocaInst>(&*ii)) {
+        if (intGuardsChecker.isGuard(var) || sexpGuardsChecker.isGuard(var)) {
+          guards.push_back(var);
+        }
+      }
+    }
+    if (guards.empty()) {
+      return;
+    }
+    for(Function::iterator bi = fun->begin(), be = fun->end(); bi != be; ++bi) {
+      BasicBlock *bb = &*bi;
+      if (bb->getSinglePredecessor() || pred_begin(bb) == pred_end(bb)) {
+        continue;
+      }
+      Instruction *first = &bb->front();
+      auto lsearch = facts->liveVars.find(first);
+      if (lsearch == facts->liveVars.end()) {
+        continue;
+      }
+      VarsLiveness& live = lsearch->second; // after the first instruction
+      StoreInst *si = dyn_cast<StoreInst>(first);
+      LoadInst *li = dyn_cast<LoadInst>(first);
+      for(std::vector<AllocaInst*>::iterator vi = guards.begin(), ve = guards.end(); vi != ve; ++vi) {
+        AllocaInst *var = *vi;
+        bool liveAtStart = (li && li->getPointerOperand() == var) ||
+          (live.isPossiblyUsed(var) && !(si && si->getPointerOperand() == var));
+        if (!liveAtStart) {
+          facts->deadGuardsAtMerges[bb].push_back(var);
+        }
+      }
+    }
+  }
+
+  // processes the non-terminator instructions of the block of state s
+  //   returns false when checking should be restarted
+  template <unsigned CHECKS> bool handleNonTerminators(BcheckStateTy& s, unsigned& refinableInfos) {
+
+    const bool intGuardsEnabled = CHECKS & CK_INTGUARDS;
+    const bool sexpGuardsEnabled = CHECKS & CK_SEXPGUARDS;
+    const bool restartable = CHECKS & CK_RESTARTABLE;
+
+    if (!MEMOIZE_BLOCKS) {
+      return transferNonTerminators<CHECKS>(s, refinableInfos);
+    }
+
+    const BlockEventsTy& be = facts->blockEvents.at(s.bb);
+    bool intGuardsUsed = intGuardsEnabled && be.intGuardsUsed;
+    bool sexpGuardsUsed = sexpGuardsEnabled && be.sexpGuardsUsed;
+    unsigned checks = (CHECKS & (CK_BALANCE | CK_FRESHVARS)) | (intGuardsUsed ? CK_INTGUARDS : 0) | (sexpGuardsUsed ? CK_SEXPGUARDS : 0);
+    BlockTransferKeyTy key(s, checks);
+
+    // in a parallel exploration, the transfers are shared by the threads
+    ConcurrentBlockTransfersTy::ShardTy *shard = parallelExploration ? &parallelExploration->blockTransfers->shard(key) : NULL;
+    BlockTransfersTy& transfers = shard ? shard->transfers : blockTransfers;
+    {
+      std::unique_lock<std::mutex> lock;
+      if (shard) {
+        lock = std::unique_lock<std::mutex>(shard->mutex);
+      }
+      auto tsearch = transfers.find(key);
+      if (tsearch != transfers.end()) {
+        const BlockTransferTy& t = tsearch->second;
+        s.balance = t.balance;
+        s.freshVars = t.freshVars;
+        if (intGuardsUsed) {
+          s.intGuards = t.intGuards;
+        }
+        if (sexpGuardsUsed) {
+          s.sexpGuards = t.sexpGuards;
+        }
+        for(LineInfoPtrVectorTy::const_iterator mi = t.messages.begin(), me = t.messages.end(); mi != me; ++mi) {
+          m.msg.emitInterned(*mi);
+        }
+        refinableInfos += t.refinableInfos;
+        return !(restartable && refinableInfos > 0);
+      }
+    }
+
+    LineInfoPtrVectorTy messages;
+    unsigned oldRefinableInfos = refinableInfos;
+    m.msg.record(&messages);
+    bool res = transferNonTerminators<CHECKS>(s, refinableInfos);
+    m.msg.record(NULL);
+
+    if (res) {
+      std::unique_lock<std::mutex> lock;
+      if (shard) {
+        lock = std::unique_lock<std::mutex>(shard->mutex);
+      }
+      transfers.insert({key, BlockTransferTy(s, messages, refinableInfos - oldRefinableInfos)});
+    }
+    return res;
+  }
+
+  template <unsigned CHECKS> bool transferNonTerminators(BcheckStateTy& s, unsigned& refinableInfos) {
+
+    const bool balanceCheckingEnabled = CHECKS & CK_BALANCE;
+    const bool freshVarsCheckingEnabled = CHECKS & CK_FRESHVARS;
+    const bool intGuardsEnabled = CHECKS & CK_INTGUARDS;
+    const bool sexpGuardsEnabled = CHECKS & CK_SEXPGUARDS;
+    const bool restartable = CHECKS & CK_RESTARTABLE;
+
+    const BlockEventsTy& be = facts->blockEvents.at(s.bb);
+    for(std::vector<InstructionEventsTy>::const_iterator ei = be.instructions.begin(), ee = be.instructions.end(); ei != ee; ++ei) {
+      Instruction *in = ei->in;
+      unsigned events = ei->events;
+      m.msg.trace("visiting", in);
+ 
+      if (freshVarsCheckingEnabled && (events & EV_FRESHVARS)) {
+        handleFreshVarsForNonTerminator(in, &m.cm, sexpGuardsEnabled ? &sexpGuardsChecker : NULL, sexpGuardsEnabled ? &s.sexpGuards : NULL, s.freshVars, 
+          m.msg, refinableInfos, facts->liveVars, m.cprotect, balanceCheckingEnabled ? &s.balance : NULL, checkedVarsCache);
+            // NOTE: must be called before balance handling
+            //  because it uses some state of balance handling that will be removed by the call to
+            //  handleBalanceForNonTerminator, e.g. re protection counter or topsave variable
+          
+        if (restartable && refinableInfos > 0) return false;
+      }
+      if (balanceCheckingEnabled && (events & EV_BALANCE)) {
+        handleBalanceForNonTerminator(in, s.balance, m.gl, counterVarsCache, saveVarsCache, m.msg, refinableInfos);
+        if (restartable && refinableInfos > 0) return false;
+      }
+ 
+      if (intGuardsEnabled && (events & EV_INTGUARDS)) {
+        intGuardsChecker.handleForNonTerminator(in, s.intGuards);
+        if (restartable && refinableInfos > 0) return false;
+      }
+      if (intGuardsEnabled && balanceCheckingEnabled && (events & EV_UNPROTECT)) {
+        handleUnprotectWithIntGuard(in, s, m.gl, intGuardsChecker, m.msg, refinableInfos);
+        if (restartable && refinableInfos > 0) return false;
+      }
+      if (sexpGuardsEnabled && (events & EV_SEXPGUARDS)) {
+        sexpGuardsChecker.handleForNonTerminator(in, s.sexpGuards);
+        if (restartable && refinableInfos > 0) return false;
+      }
+    }
+    return true;
+  }
+
+  // processes a single basic block of state s and adds the successor states
+  //   returns false when checking should be restarted
+  template <unsigned CHECKS> bool exploreState(BcheckStateTy& s, unsigned& refinableInfos) {
+
+    const bool balanceCheckingEnabled = CHECKS & CK_BALANCE;
+    const bool freshVarsCheckingEnabled = CHECKS & CK_FRESHVARS;
+    const bool intGuardsEnabled = CHECKS & CK_INTGUARDS;
+    const bool sexpGuardsEnabled = CHECKS & CK_SEXPGUARDS;
+
+    if (!handleNonTerminators<CHECKS>(s, refinableInfos)) {
+      return false;
+    }
+      
+    TerminatorInst *t = s.bb->getTerminator();
+
+    if (freshVarsCheckingEnabled) {
+      handleFreshVarsForTerminator(t, s.freshVars, facts->liveVars); // does nothing anyway
+    }
+
+    if (balanceCheckingEnabled && handleBalanceForTerminator(t, s, m.gl, counterVarsCache, m.msg, refinableInfos)) {
+      // ignore successors in case important errors were already found, and hence further
+      // errors found will just confuse the user
+      return true;
+    }
+
+    if (sexpGuardsEnabled && sexpGuardsChecker.handleForTerminator(t, s)) {
+      return true;
+    }
+
+      // int guards have to be after balance, so that "if (nprotect) UNPROTECT(nprotect)"
+      // is handled in preference of int guard
+    if (intGuardsEnabled && intGuardsChecker.handleForTerminator(t, s)) {
+      return true;
+    }
+      
+    // add conservatively all cfg successors
+    for(int i = 0, nsucc = t->getNumSuccessors(); i < nsucc; i++) {
+      BasicBlock *succ = t->getSuccessor(i);
+      {
+        BcheckStateTy* state = s.clone(succ);
+        if (state->add()) {
+          m.msg.trace("added (conservatively) successor of", t);
+        }
+      }
+    }
+    return true;
+  }
+
+  // explores states of the function in one of the threads of a parallel exploration
+  //   runs on a copy of the function checker owned by the thread (see the copy constructor)
+  template <unsigned CHECKS> void exploreStatesInThread(ParallelExplorationTy& pe, unsigned thread) {
+
+    const bool restartable = CHECKS & CK_RESTARTABLE;
+
+    ExplorationBudgetTy budget(explorationLimits.maxStates, MAX_STATES);
+    unsigned refinableInfos = 0;
+    std::string budgetExceededReason;
+
+    parallelExploration = &pe;
+    parallelThread = thread;
+    packingIntGuardsChecker = &intGuardsChecker;
+    packingSEXPGuardsChecker = &sexpGuardsChecker;
+    ::sparseSuccessors = &facts->sparseSuccessors;
+    ::deadGuardsAtMerges = &facts->deadGuardsAtMerges;
+
+    while(!pe.stopped) {
+      const BcheckPackedStateTy* ps = pe.take(thread);
+      if (!ps) {
+        if (pe.nPending == 0) {
+          break; // all states have been explored
+        }
+        pe.waitForStates(); // other threads may still add states
+        continue;
+      }
+      bool stop = false;
+      if (!ONLY_FUNCTION || ONLY_FUNCTION_NAME == fun->getName()) {
+        BcheckStateTy s(*ps, intGuardsChecker, sexpGuardsChecker); // unpacks the state
+
+        m.msg.trace("going to work on this state:", &*s.bb->begin());
+        if (facts->errorBasicBlocks.find(s.bb) != facts->errorBasicBlocks.end()) {
+          m.msg.debug("ignoring basic block on error path", &*s.bb->begin());
+        } else if (budget.exceeded(pe.nStates)) {
+          budgetExceededReason = budget.reason();
+          stop = true;
+        } else {
+          stop = !exploreState<CHECKS>(s, refinableInfos) || (restartable && refinableInfos > 0);
+        }
+      }
+      if (--pe.nPending == 0 || stop) { // after the successors have been added
+        if (stop) {
+          pe.stopped = true;
+        }
+        pe.wakeUpAll();
+      }
+    }
+    pe.finished(refinableInfos, budgetExceededReason);
+    parallelExploration = NULL;
+  }
+
+  // explores the states of the function in the threads of the exploration pool
+  //   returns false when the exploration budget has been exceeded
+  template <unsigned CHECKS> bool checkFunctionInParallel(unsigned& refinableInfos, std::string& budgetExceededReason) {
+
+    clearStates();
+    ParallelExplorationTy pe(nFunctionJobs, &concurrentBlockTransfers);
+    {
+      parallelExploration = &pe;
+      parallelThread = 0;
+      packingIntGuardsChecker = &intGuardsChecker;
+      packingSEXPGuardsChecker = &sexpGuardsChecker;
+      ::sparseSuccessors = &facts->sparseSuccessors;
+      ::deadGuardsAtMerges = &facts->deadGuardsAtMerges;
+      BcheckStateTy* initState = new BcheckStateTy(&fun->getEntryBlock());
+      initState->add();
+      parallelExploration = NULL;
+    }
+
+    // as with a single thread, variables checked in earlier runs (before a restart)
+    //   are not reported again
+    const VarBoolCacheTy checkedVarsBefore = checkedVarsCache;
+    std::mutex cachesMutex;
+    explorationPool->run([this, &pe, &checkedVarsBefore, &cachesMutex](unsigned thread) {
+      FunctionChecker threadChecker(*this);
+      threadChecker.checkedVarsCache = checkedVarsBefore;
+      threadChecker.exploreStatesInThread<CHECKS>(pe, thread);
+
+      std::lock_guard<std::mutex> lock(cachesMutex);
+      checkedVarsCache.insert(threadChecker.checkedVarsCache.begin(), threadChecker.checkedVarsCache.end());
+    });
+
+    totalStates += pe.nStates;
+    maxParallelPending = std::max(maxParallelPending, (size_t) pe.maxAvailable);
+    refinableInfos = pe.refinableInfos;
+    budgetExceededReason = pe.budgetExceededReason;
+    return budgetExceededReason.empty();
+  }
+
+  // returns false when the exploration budget has been exceeded
+  template <unsigned CHECKS> bool checkFunction(unsigned& refinableInfos, std::string& budgetExceededReason) {
+
+    const bool restartable = CHECKS & CK_RESTARTABLE;
   
+    if (parallel) {
+      std::unique_lock<std::mutex> lock(explorationPool->busy, std::try_to_lock);
+      if (lock.owns_lock()) {
+        return checkFunctionInParallel<CHECKS>(refinableInfos, budgetExceededReason);
+      }
+      // the pool is exploring a function of another thread (--jobs)
+    }
+
     refinableInfos = 0;
-    bool restartable = (!intGuardsEnabled && !avoidIntGuardsFor(fun)) || (!sexpGuardsEnabled && !avoidSEXPGuardsFor(fun));
+    ExplorationBudgetTy budget(explorationLimits.maxStates, MAX_STATES);
     clearStates();
+    workList.start(fun);
+    packingIntGuardsChecker = &intGuardsChecker;
+    packingSEXPGuardsChecker = &sexpGuardsChecker;
+    ::sparseSuccessors = &facts->sparseSuccessors;
+    ::deadGuardsAtMerges = &facts->deadGuardsAtMerges;
     {
       BcheckStateTy* initState = new BcheckStateTy(&fun->getEntryBlock());
       initState->add();
@@ -362,7 +1348,7 @@ class FunctionChecker {
     while(!workList.empty()) {
       if (restartable && refinableInfos > 0) {
         clearStates();
-        return;
+        return true;
       }
       
       if (ONLY_FUNCTION && ONLY_FUNCTION_NAME != fun->getName()) {
@@ -370,25 +1356,26 @@ class FunctionChecker {
         continue;
       }
       
+      BcheckStateTy s(*workList.top(), intGuardsChecker, sexpGuardsChecker); // unpacks the state
+      workList.pop();
+
       if (DUMP_STATES && (DUMP_STATES_FUNCTION.empty() || DUMP_STATES_FUNCTION == fun->getName())) {
         outs().flush();
         errs() << "\n -- dumping a state being visited -- \n";
-        workList.top()->dump();
+        s.dump();
       }
 
-      BcheckStateTy s(*workList.top());
-      workList.pop();
       m.msg.trace("going to work on this state:", &*s.bb->begin());
       
-      if (errorBasicBlocks.find(s.bb) != errorBasicBlocks.end()) {
+      if (facts->errorBasicBlocks.find(s.bb) != facts->errorBasicBlocks.end()) {
         m.msg.debug("ignoring basic block on error path", &*s.bb->begin());
         continue;
       }
       
-      if (doneSet.size() > MAX_STATES) {
-        errs() << "ERROR: too many states (abstraction error?) in function " << funName(fun) << "\n";
+      if (budget.exceeded(doneSet.size() + spilledStates.size())) {
+        budgetExceededReason = budget.reason();
         clearStates();
-        return;
+        return false;
       }
       
       if (PROGRESS_MARKS) {
@@ -399,97 +1386,129 @@ class FunctionChecker {
       }      
       
       // process a single basic block
-      for(BasicBlock::iterator ini = s.bb->begin(), ine = s.bb->end(); ini != ine; ++ini) {
-        Instruction *in = &*ini;
-        m.msg.trace("visiting", in);
-   
-        if (freshVarsCheckingEnabled) {
-          handleFreshVarsForNonTerminator(in, &m.cm, sexpGuardsEnabled ? &sexpGuardsChecker : NULL, sexpGuardsEnabled ? &s.sexpGuards : NULL, s.freshVars, 
-            m.msg, refinableInfos, liveVars, m.cprotect, balanceCheckingEnabled ? &s.balance : NULL, checkedVarsCache);
-              // NOTE: must be called before balance handling
-              //  because it uses some state of balance handling that will be removed by the call to
-              //  handleBalanceForNonTerminator, e.g. re protection counter or topsave variable
-            
-          if (restartable && refinableInfos > 0) { clearStates(); return; }
-        }
-        if (balanceCheckingEnabled) {
-          handleBalanceForNonTerminator(in, s.balance, m.gl, counterVarsCache, saveVarsCache, m.msg, refinableInfos);
-          if (restartable && refinableInfos > 0) { clearStates(); return; }
-        }
- 
-        if (intGuardsEnabled) {
-          intGuardsChecker.handleForNonTerminator(in, s.intGuards);
-          if (restartable && refinableInfos > 0) { clearStates(); return; }
-          if (balanceCheckingEnabled) {
-            handleUnprotectWithIntGuard(in, s, m.gl, intGuardsChecker, m.msg, refinableInfos);
-            if (restartable && refinableInfos > 0) { clearStates(); return; }
-          }
-        }
-        if (sexpGuardsEnabled) {
-          sexpGuardsChecker.handleForNonTerminator(in, s.sexpGuards);
-          if (restartable && refinableInfos > 0) { clearStates(); return; }
-        }
+      if (!exploreState<CHECKS>(s, refinableInfos)) {
+        clearStates();
+        return true;
       }
-      
-      TerminatorInst *t = s.bb->getTerminator();
+    }
+    return true;
+  }
+  
+  typedef bool (FunctionChecker::*CheckFunctionTy)(unsigned&, std::string&);
 
-      if (freshVarsCheckingEnabled) {
-        handleFreshVarsForTerminator(t, s.freshVars, liveVars); // does nothing anyway
+  // the table of checkFunction<CHECKS>... for the given combinations of checks
+  template <unsigned... CHECKS> struct CheckFunctionsTableTy {
+    static CheckFunctionTy get(unsigned checks) {
+      static const unsigned combinations[] = { CHECKS... };
+      static const CheckFunctionTy checkFunctions[] = { &FunctionChecker::checkFunction<CHECKS>... };
+      for(unsigned i = 0; i < sizeof...(CHECKS); i++) {
+        if (combinations[i] == checks) {
+          return checkFunctions[i];
+        }
       }
+      myassert(false);
+      return NULL;
+    }
+  };
 
-      if (balanceCheckingEnabled && handleBalanceForTerminator(t, s, m.gl, counterVarsCache, m.msg, refinableInfos)) {
-        // ignore successors in case important errors were already found, and hence further
-        // errors found will just confuse the user
-        continue;
-      }
+  // only the combinations reachable from checkFunction below are specialized
+  //   a restart adds int guards (unless avoided) and then SEXP guards, so restartable
+  //   checking never has SEXP guards; a fallback drops the guards and restarts, and
+  //   then drops checking of fresh variables
+  //
+  //   the second parameter is only there so that the specialization is partial
+  template <bool SEPARATE, unsigned BF = CK_BALANCE | CK_FRESHVARS> struct ReachableCheckFunctionsTy : CheckFunctionsTableTy<
+    BF, BF | CK_INTGUARDS, BF | CK_SEXPGUARDS, BF | CK_INTGUARDS | CK_SEXPGUARDS, BF | CK_RESTARTABLE, BF | CK_RESTARTABLE | CK_INTGUARDS,
+    CK_BALANCE> {};
 
-      if (sexpGuardsEnabled && sexpGuardsChecker.handleForTerminator(t, s)) {
-        continue;
-      }
+  template <unsigned BF> struct ReachableCheckFunctionsTy<true, BF> : CheckFunctionsTableTy< // SEPARATE_CHECKING
+    CK_BALANCE, CK_BALANCE | CK_INTGUARDS, CK_BALANCE | CK_SEXPGUARDS, CK_BALANCE | CK_INTGUARDS | CK_SEXPGUARDS,
+    CK_BALANCE | CK_RESTARTABLE, CK_BALANCE | CK_RESTARTABLE | CK_INTGUARDS,
+    CK_FRESHVARS, CK_FRESHVARS | CK_INTGUARDS, CK_FRESHVARS | CK_SEXPGUARDS, CK_FRESHVARS | CK_INTGUARDS | CK_SEXPGUARDS,
+    CK_FRESHVARS | CK_RESTARTABLE, CK_FRESHVARS | CK_RESTARTABLE | CK_INTGUARDS> {};
 
-        // int guards have to be after balance, so that "if (nprotect) UNPROTECT(nprotect)"
-        // is handled in preference of int guard
-      if (intGuardsEnabled && intGuardsChecker.handleForTerminator(t, s)) {
-        continue;
-      }
-      
-      // add conservatively all cfg successors
-      for(int i = 0, nsucc = t->getNumSuccessors(); i < nsucc; i++) {
-        BasicBlock *succ = t->getSuccessor(i);
-        {
-          BcheckStateTy* state = s.clone(succ);
-          if (state->add()) {
-            m.msg.trace("added (conservatively) successor of", t);
-          }
-        }
-      }
-    }
+  // runs the exploration specialized for the given checks
+  bool checkFunction(bool intGuardsEnabled, bool sexpGuardsEnabled, bool balanceCheckingEnabled, bool freshVarsCheckingEnabled, bool restartable,
+      unsigned& refinableInfos, std::string& budgetExceededReason) {
+
+    unsigned checks = (balanceCheckingEnabled ? CK_BALANCE : 0) | (freshVarsCheckingEnabled ? CK_FRESHVARS : 0) |
+      (intGuardsEnabled ? CK_INTGUARDS : 0) | (sexpGuardsEnabled ? CK_SEXPGUARDS : 0) | (restartable ? CK_RESTARTABLE : 0);
+    CheckFunctionTy check = ReachableCheckFunctionsTy<SEPARATE_CHECKING>::get(checks);
+    return (this->*check)(refinableInfos, budgetExceededReason);
   }
-  
+
   public:
+    // a checker for a thread of a parallel exploration
+    //   shares the facts about the function, which are only read, but has its own
+    //   caches and guard checkers, which are written while exploring the states
+    //   (the guard checkers have indexed the variables, so they pack the same way)
+    FunctionChecker(const FunctionChecker& other):
+        fun(other.fun), saveVarsCache(), counterVarsCache(), checkedVarsCache(), intGuardsChecker(other.intGuardsChecker),
+        sexpGuardsChecker(other.sexpGuardsChecker), facts(other.facts), parallel(other.parallel), m(other.m) {};
+
     FunctionChecker(Function *fun, ModuleCheckingStateTy& moduleState): 
         fun(fun), saveVarsCache(), counterVarsCache(), checkedVarsCache(), intGuardsChecker(&moduleState.msg), 
         /* TODO: we would need "sure" allocators here instead of possible allocators! */
         sexpGuardsChecker(&moduleState.msg, &moduleState.gl, 
           USE_ALLOCATOR_DETECTION ? moduleState.cm.getContextSensitivePossibleAllocators() : NULL, moduleState.cm.getSymbolsMap(), NULL, moduleState.cm.getVrfState(), &moduleState.cm),
-        errorBasicBlocks(), m(moduleState) {
+        facts(new FunctionFactsTy()),
+        parallel(nFunctionJobs > 1 && fun->size() >= PARALLEL_EXPLORATION_MIN_BLOCKS), m(moduleState) {
         
-      findErrorBasicBlocks(fun, &m.errorFunctions, errorBasicBlocks);
-      liveVars = findLiveVariables(fun);
+      findErrorBasicBlocks(fun, &m.errorFunctions, facts->errorBasicBlocks);
+      facts->liveVars = findLiveVariables(fun);
+      for(Function::iterator bi = fun->begin(), be = fun->end(); bi != be; ++bi) {
+        BasicBlock *bb = &*bi;
+        decodeBlock(bb, facts->blockEvents[bb]);
+      }
+      if (SPARSE_EXPLORATION) {
+        findSparseSuccessors();
+      }
+      if (widenLimit) {
+        findDeadGuardsAtMerges();
+      }
+      if (parallel) {
+        // all threads need to pack guards the same way
+        intGuardsChecker.indexVariables(fun);
+        sexpGuardsChecker.indexVariables(fun);
+      }
     }  
   
     // handles restarts
+    //   the memoized block transfers are kept when restarting with more precise guards
+    //   when the exploration budget is exceeded, falls back to less precise checking:
+    //   first without guards (and without restarts), then checking only the protection balance
     void checkFunction(bool balanceCheckingEnabled, bool freshVarsCheckingEnabled, std::string checksName) {
 
       m.msg.newFunction(fun, checksName);
       bool intGuardsEnabled = false;
       bool sexpGuardsEnabled = false;
+      bool refinable = true;
       unsigned refinableInfos;
     
       for(;;) {
-        checkFunction(intGuardsEnabled, sexpGuardsEnabled, balanceCheckingEnabled, freshVarsCheckingEnabled, refinableInfos);
+        bool restartable = refinable && ((!intGuardsEnabled && !avoidIntGuardsFor(fun)) || (!sexpGuardsEnabled && !avoidSEXPGuardsFor(fun)));
+        std::string reason;
+        
+        if (!checkFunction(intGuardsEnabled, sexpGuardsEnabled, balanceCheckingEnabled, freshVarsCheckingEnabled, restartable, refinableInfos, reason)) {
+          m.msg.clear();
+          clearBlockTransfers(); // may be the memory limit
+          if (intGuardsEnabled || sexpGuardsEnabled) {
+            m.err << "WARNING: " << reason << " in function " << funName(fun) << ", checking it without guards\n";
+            intGuardsEnabled = false;
+            sexpGuardsEnabled = false;
+            refinable = false;
+            continue;
+          }
+          if (balanceCheckingEnabled && freshVarsCheckingEnabled) {
+            m.err << "WARNING: " << reason << " in function " << funName(fun) << ", checking only protection balance\n";
+            freshVarsCheckingEnabled = false;
+            refinable = false;
+            continue;
+          }
+          m.err << "ERROR: " << reason << " (abstraction error?) in function " << funName(fun) << "\n";
+          break;
+        }
     
-        bool restartable = (!intGuardsEnabled && !avoidIntGuardsFor(fun)) || (!sexpGuardsEnabled && !avoidSEXPGuardsFor(fun));
         if (restartable && refinableInfos>0) {
           // retry with more precise checking
           m.msg.clear();
@@ -502,42 +1521,181 @@ class FunctionChecker {
           break;
         }
       }
+      clearBlockTransfers();
     }
 };
 
 
-// -------------------------------- main  -----------------------------------
+bool reportFunctionStates = false; // --function-states, e.g. to compare the precision of --widen
 
-int main(int argc, char* argv[])
-{
-  LLVMContext context;
-  FunctionsOrderedSetTy functionsOfInterestSet;
-  FunctionsVectorTy functionsOfInterestVector;
+static void checkFunction(Function *fun, ModuleCheckingStateTy& mstate) {
+
+  FunctionChecker fchk(fun, mstate);
+  unsigned long statesBefore = totalStates;
+
+  if (SEPARATE_CHECKING) {
+      // FIXME: it would make more sense to only print prefixes [BP] and [UP] with join checking
+    fchk.checkFunction(true, false, " [protection balance]");
+    fchk.checkFunction(false, true, " [unprotected pointers]");
+  } else {
+    fchk.checkFunction(true, true, "");  
+  }
+  if (reportFunctionStates) {
+    clearStates(); // counts the states of the last run
+    mstate.err << "INFO: traversed " << (totalStates - statesBefore) << " states in function " << funName(fun) << "\n";
+  }
+}
+
+// -------------------------------- parallel checking -----------------------------------
+
+// functions are checked by worker threads, each with its own line messenger
+// and exploration state; the output for each function is buffered and printed
+// in the order of the functions, so that it is the same as with serial
+// checking
+
+struct FunctionOutputTy {
+  std::string out;
+  std::string err;
+  bool done;
   
-  Module *m = parseArgsReadIR(argc, argv, functionsOfInterestSet, functionsOfInterestVector, context);
-//  EXCLUDE_PROTECTION_FUNCTIONS = (argc == 3); // exclude when checking modules
-  GlobalsTy gl(m);
-  LineMessenger msg(context, DEBUG, TRACE, UNIQUE_MSG);
+  FunctionOutputTy(): out(), err(), done(false) {};
+};
+
+struct ParallelCheckingTy {
+  FunctionsVectorTy& functions;
+  ModuleCheckingStateTy& mstate;
+  LLVMContext& context;
   
-  FunctionsSetTy errorFunctions;
-  findErrorFunctions(m, errorFunctions);
+  std::atomic<unsigned> nextFunction; // next function to be checked
+  
+  std::mutex outputMutex; // protects the fields below
+  std::vector<FunctionOutputTy> outputs;
+  unsigned nextOutput; // next function to be printed
+  unsigned long totalStates;
+  size_t maxPending; // largest worklist
+  
+  ParallelCheckingTy(FunctionsVectorTy& functions, ModuleCheckingStateTy& mstate, LLVMContext& context):
+    functions(functions), mstate(mstate), context(context), nextFunction(0), outputMutex(), outputs(functions.size()),
+    nextOutput(0), totalStates(0), maxPending(0) {};
+  
+  void functionChecked(unsigned idx, std::string& out, std::string& err) {
+    std::lock_guard<std::mutex> lock(outputMutex);
+    FunctionOutputTy& o = outputs.at(idx);
+    o.out.swap(out);
+    o.err.swap(err);
+    o.done = true;
+    
+    for(; nextOutput < outputs.size() && outputs[nextOutput].done; nextOutput++) {
+      FunctionOutputTy& n = outputs[nextOutput];
+      errs() << n.err;
+      outs() << n.out;
+      std::string().swap(n.out);
+      std::string().swap(n.err);
+    }
+  }
+  
+  void worker() {
+    LineMessenger msg(context, DEBUG, TRACE, UNIQUE_MSG);
+    
+    for(;;) {
+      unsigned idx = nextFunction++;
+      if (idx >= functions.size()) {
+        break;
+      }
+      std::string out;
+      std::string err;
+      {
+        raw_string_ostream outStream(out);
+        raw_string_ostream errStream(err);
+        ModuleCheckingStateTy wstate(mstate, msg, errStream);
+      
+        msg.setOutput(outStream);
+        checkFunction(functions.at(idx), wstate);
+        msg.flush();
+        outStream.flush();
+        errStream.flush();
+      }
+      functionChecked(idx, out, err);
+    }
+    clearStates();
+    
+    std::lock_guard<std::mutex> lock(outputMutex);
+    totalStates += ::totalStates;
+    maxPending = std::max(maxPending, std::max(workList.peakSize(), maxParallelPending));
+  }
+};
 
-  FunctionsSetTy possibleAllocators;
-  findPossibleAllocators(m, possibleAllocators);
+static unsigned long checkFunctionsInParallel(FunctionsVectorTy& functions, ModuleCheckingStateTy& mstate, LLVMContext& context, unsigned nJobs,
+    size_t& maxPending) {
 
-  FunctionsSetTy allocatingFunctions;
-  findAllocatingFunctions(m, allocatingFunctions);
+  ParallelCheckingTy pc(functions, mstate, context);
+  std::vector<std::thread> workers;
+  
+  for(unsigned i = 0; i < nJobs; i++) {
+    workers.push_back(std::thread(&ParallelCheckingTy::worker, &pc));
+  }
+  for(unsigned i = 0; i < nJobs; i++) {
+    workers[i].join();
+  }
+  myassert(pc.nextOutput == functions.size());
+  maxPending = pc.maxPending;
+  return pc.totalStates;
+}
 
-  SymbolsMapTy symbolsMap;
-  findSymbols(m, &symbolsMap);
+// -------------------------------- main  -----------------------------------
+
+static unsigned long nJobs = 1;
+
+static bool extractBcheckOptions(int& argc, char* argv[])
+{
+  std::string jobsArg;
+  if (extractOption(argc, argv, "jobs", jobsArg) && (!parseUnsigned(jobsArg, nJobs) || nJobs == 0)) {
+    errs() << "Invalid number of jobs: " << jobsArg << "\n";
+    return false;
+  }
+  std::string widenArg;
+  if (extractOption(argc, argv, "widen", widenArg) && !parseUnsigned(widenArg, widenLimit)) {
+    errs() << "Invalid number of states per block: " << widenArg << "\n";
+    return false;
+  }
+  std::string functionJobsArg;
+  if (extractOption(argc, argv, "function-jobs", functionJobsArg) && (!parseUnsigned(functionJobsArg, nFunctionJobs) || nFunctionJobs == 0)) {
+    errs() << "Invalid number of jobs per function: " << functionJobsArg << "\n";
+    return false;
+  }
+  if (nFunctionJobs > 1 && widenLimit) {
+    errs() << "Widening (--widen) depends on the order of states, it cannot be used with --function-jobs\n";
+    return false;
+  }
+  reportFunctionStates = extractFlag(argc, argv, "function-states");
+  allocatorJobs = nJobs; // unless given by --allocator-jobs
+  return true;
+}
+
+static int runBcheck(ModuleAnalysesTy& analyses, FunctionsOrderedSetTy& functionsOfInterestSet, FunctionsVectorTy& functionsOfInterestVector)
+{
+  if (nFunctionJobs > 1 && spillOptions.enabled()) { // spill options are extracted after those of the tool (see runTool)
+    errs() << "Spilling (--spill-dir) is not supported for functions explored in multiple threads, it cannot be used with --function-jobs\n";
+    return 1;
+  }
+  Module *m = analyses.getModule();
+  LLVMContext& context = m->getContext();
+//  EXCLUDE_PROTECTION_FUNCTIONS = (argc == 3); // exclude when checking modules
+  GlobalsTy& gl = *analyses.getGlobals();
+  LineMessenger msg(context, DEBUG, TRACE, UNIQUE_MSG);
+  
+  FunctionsSetTy& errorFunctions = *analyses.getErrorFunctions();
+  FunctionsSetTy& possibleAllocators = *analyses.getPossibleAllocators();
+  FunctionsSetTy& allocatingFunctions = *analyses.getAllocatingFunctions();
   
-  CalledModuleTy cm(m, &symbolsMap, &errorFunctions, &gl, &possibleAllocators, &allocatingFunctions);
-  CProtectInfo cprotect = findCalleeProtectFunctions(m, *cm.getContextSensitiveAllocatingFunctions());
+  CalledModuleTy& cm = *analyses.getCalledModule();
+  CProtectInfo& cprotect = *analyses.getCalleeProtect();
+  cm.computeVectorReturningFunctions(); // otherwise computed lazily, which would be racy with parallel checking
   
-  ModuleCheckingStateTy mstate(possibleAllocators, allocatingFunctions, errorFunctions, gl, msg, cm, cprotect); 
+  ModuleCheckingStateTy mstate(possibleAllocators, allocatingFunctions, errorFunctions, gl, msg, cm, cprotect, errs()); 
     // FIXME: perhaps get rid of ModuleCheckingState now that we have CalledModule
 
-  unsigned nAnalyzedFunctions = 0;
+  FunctionsVectorTy functionsToCheck;
   for(FunctionsVectorTy::iterator FI = functionsOfInterestVector.begin(), FE = functionsOfInterestVector.end(); FI != FE; ++FI) {
     Function *fun = *FI;
 
@@ -552,23 +1710,47 @@ int main(int argc, char* argv[])
       
       continue;
     }
-    
-    nAnalyzedFunctions++;
-    FunctionChecker fchk(fun, mstate);
+    functionsToCheck.push_back(fun);
+  }
+  unsigned nAnalyzedFunctions = functionsToCheck.size();
+  size_t maxPending;
 
-    if (SEPARATE_CHECKING) {
-        // FIXME: it would make more sense to only print prefixes [BP] and [UP] with join checking
-      fchk.checkFunction(true, false, " [protection balance]");
-      fchk.checkFunction(false, true, " [unprotected pointers]");
-    } else {
-      fchk.checkFunction(true, true, "");  
+  std::unique_ptr<ExplorationPoolTy> pool;
+  if (nFunctionJobs > 1) {
+    pool.reset(new ExplorationPoolTy(nFunctionJobs));
+    explorationPool = pool.get();
+  }
+  
+  if (nJobs > 1) {
+    totalStates = checkFunctionsInParallel(functionsToCheck, mstate, context, nJobs, maxPending);
+  } else {
+    for(FunctionsVectorTy::iterator FI = functionsToCheck.begin(), FE = functionsToCheck.end(); FI != FE; ++FI) {
+      checkFunction(*FI, mstate);
     }
+    msg.flush();
+    clearStates();
+    maxPending = std::max(workList.peakSize(), maxParallelPending);
   }
-  msg.flush();
-  clearStates();
-  delete m;
+  explorationPool = NULL; // the pool is stopped when leaving
 
   outs().flush();
-  errs() << "Analyzed " << nAnalyzedFunctions << " functions, traversed " << totalStates << " states.\n";
+  errs() << "Analyzed " << nAnalyzedFunctions << " functions, traversed " << totalStates << " states";
+  if (widenLimit) {
+    errs() << ", widening guards beyond " << widenLimit << " states per block";
+  }
+  if (workListStrategyGiven || workListStrategy != WS_DFS) {
+    // to compare strategies
+    errs() << " (" << workListStrategyName(workListStrategy) << " worklist, at most " << maxPending << " pending)";
+  }
+  errs() << ".\n";
   return 0;
 }
+
+const ToolTy bcheckTool = {"bcheck", extractBcheckOptions, runBcheck, false, true};
+
+#ifndef RCHK_DRIVER
+int main(int argc, char* argv[])
+{
+  return runTool(bcheckTool, argc, argv);
+}
+#endif
@@ -0,0 +1,113 @@
+
+#include "budget.h"
+#include "common.h"
+#include "spill.h"
+
+#include <climits>
+#include <fstream>
+
+#include <unistd.h>
+#ifdef __GLIBC__
+  #include <malloc.h>
+#endif
+
+#include <llvm/Support/raw_ostream.h>
+
+using namespace llvm;
+
+ExplorationLimitsTy explorationLimits;
+
+bool parseMemorySize(const std::string& str, unsigned long& bytes) {
+
+  size_t len = str.size();
+  unsigned long unit = 1;
+
+  if (len > 0) {
+    switch(str[len - 1]) {
+      case 'k': case 'K': unit = 1UL << 10; len--; break;
+      case 'm': case 'M': unit = 1UL << 20; len--; break;
+      case 'g': case 'G': unit = 1UL << 30; len--; break;
+      case 't': case 'T': unit = 1UL << 40; len--; break;
+    }
+  }
+  unsigned long value;
+  if (!parseUnsigned(str.substr(0, len), value) || value > ULONG_MAX / unit) {
+    return false;
+  }
+  bytes = value * unit;
+  return true;
+}
+
+bool extractExplorationLimits(int& argc, char* argv[]) {
+
+  std::string arg;
+  if (extractOption(argc, argv, "max-states", arg) && !parseUnsigned(arg, explorationLimits.maxStates)) {
+    errs() << "Invalid maximum number of states: " << arg << "\n";
+    return false;
+  }
+  if (extractOption(argc, argv, "max-allocator-states", arg) && !parseUnsigned(arg, explorationLimits.maxAllocatorStates)) {
+    errs() << "Invalid maximum number of states for computing allocators: " << arg << "\n";
+    return false;
+  }
+  if (extractOption(argc, argv, "max-time", arg) && !parseUnsigned(arg, explorationLimits.maxSeconds)) {
+    errs() << "Invalid time limit (seconds): " << arg << "\n";
+    return false;
+  }
+  if (extractOption(argc, argv, "max-memory", arg) && !parseMemorySize(arg, explorationLimits.maxMemory)) {
+    errs() << "Invalid memory limit: " << arg << "\n";
+    return false;
+  }
+  return true;
+}
+
+unsigned long residentMemory() {
+
+  // Linux only
+  //   file-backed pages (e.g. of spilled states) are not counted, the system can reclaim them
+  std::ifstream statm("/proc/self/statm");
+  unsigned long size, resident, shared;
+  if (!(statm >> size >> resident >> shared)) {
+    return 0;
+  }
+  return (resident - shared) * sysconf(_SC_PAGESIZE);
+}
+
+ExplorationBudgetTy::ExplorationBudgetTy(unsigned long limitMaxStates, unsigned long defaultMaxStates):
+  maxStates(limitMaxStates ? limitMaxStates : (spillOptions.enabled() ? ULONG_MAX : defaultMaxStates)), start(std::chrono::steady_clock::now()),
+  nChecks(0), memoryTrimmed(false), exceededReason("") {};
+
+bool ExplorationBudgetTy::exceeded(unsigned long nStates) {
+
+  if (nStates > maxStates) {
+    exceededReason = "too many states";
+    return true;
+  }
+  if (++nChecks % EXPENSIVE_CHECK_INTERVAL) {
+    return false;
+  }
+  if (explorationLimits.maxSeconds &&
+      std::chrono::steady_clock::now() - start > std::chrono::seconds(explorationLimits.maxSeconds)) {
+    exceededReason = "time limit exceeded";
+    return true;
+  }
+  if (explorationLimits.maxMemory) {
+    if (residentMemory() <= explorationLimits.maxMemory) {
+      return false;
+    }
+#ifdef __GLIBC__
+    // memory freed after checking previous functions (or by a more precise
+    //   exploration of this one) may still be counted
+    //   trimming is slow, so it is only done once per budget
+    if (!memoryTrimmed) {
+      memoryTrimmed = true;
+      malloc_trim(0);
+      if (residentMemory() <= explorationLimits.maxMemory) {
+        return false;
+      }
+    }
+#endif
+    exceededReason = "memory limit exceeded";
+    return true;
+  }
+  return false;
+}
@@ -0,0 +1,56 @@
+#ifndef RCHK_BUDGET_H
+#define RCHK_BUDGET_H
+
+#include <chrono>
+#include <string>
+
+// limits for exploring the states of a single function (bcheck, callocators)
+//   they can be set at runtime using command line options of all tools
+//     --max-states N              states per function checked by bcheck
+//     --max-allocator-states N    states per function explored to find context-sensitive
+//                                 allocators (see callocators.h)
+//     (both by default not limited with --spill-dir, see spill.h)
+//     --max-time N      seconds per function
+//     --max-memory N    resident memory of the whole process, e.g. 6G or 512M
+//
+//   the memory limit is for the whole process, so with multiple threads (--jobs,
+//   --function-jobs) which function exceeds it depends on the timing of the threads,
+//   and so do the results (the function is checked less precisely)
+
+//   the analyses have different default limits on the number of states, so they
+//   are set separately
+
+struct ExplorationLimitsTy {
+  unsigned long maxStates;          // bcheck, 0 means the default
+  unsigned long maxAllocatorStates; // callocators, 0 means the default
+  unsigned long maxSeconds;         // 0 means no limit
+  unsigned long maxMemory;          // in bytes, 0 means no limit
+
+  ExplorationLimitsTy(): maxStates(0), maxAllocatorStates(0), maxSeconds(0), maxMemory(0) {};
+};
+
+extern ExplorationLimitsTy explorationLimits;
+
+bool extractExplorationLimits(int& argc, char* argv[]); // false on invalid options
+bool parseMemorySize(const std::string& str, unsigned long& bytes);
+unsigned long residentMemory(); // 0 if not known
+
+// budget for exploring a single function
+
+class ExplorationBudgetTy {
+  unsigned long maxStates;
+  std::chrono::steady_clock::time_point start;
+  unsigned nChecks;
+  bool memoryTrimmed; // when over the memory limit
+  const char* exceededReason;
+
+  static const unsigned EXPENSIVE_CHECK_INTERVAL = 1024; // check time and memory only sometimes
+
+  public:
+    ExplorationBudgetTy(unsigned long limitMaxStates, unsigned long defaultMaxStates); // limit from explorationLimits, 0 for the default
+    bool exceeded(unsigned long nStates);
+    std::string reason() const { return exceededReason; } // after exceeded() returned true
+    unsigned long getMaxStates() const { return maxStates; }
+};
+
+#endif
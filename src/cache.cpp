@@ -0,0 +1,348 @@
+
+#include "cache.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <llvm/ADT/SmallString.h>
+#include <llvm/Support/MD5.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/raw_ostream.h>
+
+using namespace llvm;
+
+const std::string CACHE_HEADER = "rchk analyses cache 2\n"; // change when the format or the analyses change
+
+AnalysesCacheTy analysesCache;
+
+bool extractCacheOptions(int& argc, char* argv[]) {
+
+  std::string dir;
+  if (extractOption(argc, argv, "cache-dir", dir)) {
+    if (dir.empty()) {
+      errs() << "Invalid cache directory\n";
+      return false;
+    }
+    analysesCache.setDir(dir);
+  }
+  return true;
+}
+
+void CacheWriterTy::put(unsigned long n) {
+  buf += std::to_string(n);
+  buf += ' ';
+}
+
+void CacheWriterTy::put(const std::string& s) {
+  put(s.size());
+  buf += s;
+  buf += ' ';
+}
+
+void CacheWriterTy::put(const Function *f) {
+  put(f->getName().str());
+}
+
+bool CacheReaderTy::get(unsigned long& n) {
+
+  size_t end = buf.find(' ', pos);
+  if (end == std::string::npos || !parseUnsigned(buf.substr(pos, end - pos), n)) {
+    return false;
+  }
+  pos = end + 1;
+  return true;
+}
+
+bool CacheReaderTy::get(std::string& s) {
+
+  unsigned long len;
+  if (!get(len) || pos + len + 1 > buf.size() || buf[pos + len] != ' ') {
+    return false;
+  }
+  s = buf.substr(pos, len);
+  pos += len + 1;
+  return true;
+}
+
+bool CacheReaderTy::get(Function*& f) {
+
+  std::string name;
+  if (!get(name)) {
+    return false;
+  }
+  f = m->getFunction(name);
+  return f != NULL;
+}
+
+void AnalysesCacheTy::setBase(Module *base, const std::string& baseFname) {
+
+  if (dir.empty()) {
+    return;
+  }
+  auto buffer = MemoryBuffer::getFile(baseFname);
+  if (!buffer) {
+    errs() << "WARNING: cannot read " << baseFname << " to compute its hash, not using analyses cache\n";
+    return;
+  }
+  MD5 hash;
+  hash.update((*buffer)->getBuffer());
+  MD5::MD5Result result;
+  hash.final(result);
+  SmallString<32> hex;
+  MD5::stringifyResult(result, hex);
+
+  fileName = dir + "/rchk-" + hex.str().str() + ".cache";
+  module = base;
+  valid = true;
+
+  for(Module::iterator fi = base->begin(), fe = base->end(); fi != fe; ++fi) {
+    Function *f = &*fi;
+    baseFunctions.insert(f);
+    baseNames.insert({f, f->getName().str()});
+    baseFunctionNames.insert(f->getName().str());
+    if (f->isDeclaration()) {
+      baseDeclarationNames.insert(f->getName().str());
+    }
+  }
+  for(Module::global_iterator gi = base->global_begin(), ge = base->global_end(); gi != ge; ++gi) {
+    GlobalVariable *gv = &*gi;
+    baseGlobals.insert(gv);
+    baseNames.insert({gv, gv->getName().str()});
+    baseGlobalNames.insert(gv->getName().str());
+  }
+}
+
+// false when the cached results could be applied to a different function or
+// variable than the one they were computed for
+bool AnalysesCacheTy::checkLinkedName(const GlobalValue *gv, const std::unordered_set<std::string>& names) {
+
+  std::string name = gv->getName().str();
+  auto bsearch = baseNames.find(gv);
+
+  if (bsearch == baseNames.end()) {
+    if (names.find(name) != names.end()) {
+      if (isa<Function>(gv) && !gv->isDeclaration() && baseDeclarationNames.find(name) != baseDeclarationNames.end()) {
+        errs() << "WARNING: package defines function " << name << " declared in the base module, not using analyses cache\n";
+      } else {
+        errs() << "WARNING: package symbol " << name << " has the name of a base symbol, not using analyses cache\n";
+      }
+      return false;
+    }
+    return true; // package symbol
+  }
+  if (bsearch->second != name) {
+    errs() << "WARNING: base symbol " << bsearch->second << " was renamed to " << name << " when linking, not using analyses cache\n";
+    return false;
+  }
+  return true;
+}
+
+void AnalysesCacheTy::setLinked() {
+
+  if (!valid) {
+    return;
+  }
+  linked = true;
+
+  // the linker keeps the objects of the base module, but it replaces base
+  //   declarations the package defines, and it renames internal base symbols
+  //   that clash with package symbols
+  FunctionsSetTy linkedFunctions;
+  for(Module::iterator fi = module->begin(), fe = module->end(); fi != fe; ++fi) {
+    Function *f = &*fi;
+    if (!checkLinkedName(f, baseFunctionNames)) {
+      valid = false;
+      return;
+    }
+    if (baseFunctions.find(f) != baseFunctions.end()) {
+      linkedFunctions.insert(f);
+    }
+  }
+  for(Module::global_iterator gi = module->global_begin(), ge = module->global_end(); gi != ge; ++gi) {
+    if (!checkLinkedName(&*gi, baseGlobalNames)) {
+      valid = false;
+      return;
+    }
+  }
+  baseFunctions.swap(linkedFunctions); // without replaced declarations
+}
+
+void AnalysesCacheTy::getPackageFunctions(FunctionsVectorTy& functions) {
+
+  for(Module::iterator fi = module->begin(), fe = module->end(); fi != fe; ++fi) {
+    Function *f = &*fi;
+    if (!isBaseFunction(f)) {
+      functions.push_back(f);
+    }
+  }
+}
+
+// identifies the contents of the cache file, so that an unchanged file is not read again
+
+static std::string fileVersion(const std::string& fileName) {
+
+  struct stat st;
+  if (stat(fileName.c_str(), &st) != 0) {
+    return std::string();
+  }
+  return std::to_string(st.st_size) + ":" + std::to_string(st.st_mtim.tv_sec) + ":" + std::to_string(st.st_mtim.tv_nsec) +
+    ":" + std::to_string(st.st_ino);
+}
+
+// reads the sections from the cache file
+//   a missing or corrupted file is treated as empty
+
+static void readCacheFile(const std::string& fileName, std::map<std::string, std::string>& sections) {
+
+  std::ifstream in(fileName, std::ios::binary);
+  if (!in) {
+    return;
+  }
+  std::stringstream ss;
+  ss << in.rdbuf();
+  std::string contents = ss.str();
+
+  if (contents.compare(0, CACHE_HEADER.size(), CACHE_HEADER) != 0) {
+    return;
+  }
+  std::string body = contents.substr(CACHE_HEADER.size());
+  CacheReaderTy reader(body, NULL);
+  std::map<std::string, std::string> read;
+
+  while(!reader.atEnd()) {
+    std::string name;
+    std::string payload;
+    if (!reader.get(name) || !reader.get(payload)) {
+      return;
+    }
+    read[name] = payload;
+  }
+  sections.swap(read);
+}
+
+void AnalysesCacheTy::loadFile() {
+
+  if (!loaded) {
+    loadedVersion = fileVersion(fileName);
+    readCacheFile(fileName, sections);
+    loaded = true;
+  }
+}
+
+void AnalysesCacheTy::reload() {
+
+  if (!valid) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(mutex);
+  std::string version = fileVersion(fileName);
+  if (loaded && version == loadedVersion) {
+    return;
+  }
+  sections.clear();
+  readCacheFile(fileName, sections);
+  loaded = true;
+  loadedVersion = version;
+}
+
+// sections written by other processes in the meantime are kept
+void AnalysesCacheTy::writeFile() {
+
+  std::map<std::string, std::string> onDisk;
+  readCacheFile(fileName, onDisk);
+  for(std::map<std::string, std::string>::iterator si = onDisk.begin(), se = onDisk.end(); si != se; ++si) {
+    sections.insert(*si); // does not overwrite
+  }
+
+  CacheWriterTy writer;
+  for(std::map<std::string, std::string>::iterator si = sections.begin(), se = sections.end(); si != se; ++si) {
+    writer.put(si->first);
+    writer.put(si->second);
+  }
+
+  std::string tmpName = fileName + ".tmp" + std::to_string(getpid());
+  {
+    std::ofstream out(tmpName, std::ios::binary | std::ios::trunc);
+    out << CACHE_HEADER << writer.str();
+    if (!out) {
+      errs() << "WARNING: cannot write analyses cache " << tmpName << "\n";
+      std::remove(tmpName.c_str());
+      return;
+    }
+  }
+  if (std::rename(tmpName.c_str(), fileName.c_str()) != 0) {
+    errs() << "WARNING: cannot write analyses cache " << fileName << "\n";
+    std::remove(tmpName.c_str());
+  }
+}
+
+bool AnalysesCacheTy::get(Module *m, const std::string& section, std::string& payload) {
+
+  if (!enabled(m)) {
+    return false;
+  }
+  std::lock_guard<std::mutex> lock(mutex);
+  loadFile();
+  auto ssearch = sections.find(section);
+  if (ssearch == sections.end()) {
+    return false;
+  }
+  payload = ssearch->second;
+  return true;
+}
+
+void AnalysesCacheTy::put(Module *m, const std::string& section, const std::string& payload) {
+
+  if (!enabled(m)) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(mutex);
+  loadFile();
+  sections[section] = payload;
+  writeFile();
+}
+
+bool AnalysesCacheTy::getFunctions(Module *m, const std::string& section, FunctionsSetTy& functions) {
+
+  std::string payload;
+  if (!get(m, section, payload)) {
+    return false;
+  }
+  CacheReaderTy reader(payload, m);
+  FunctionsSetTy cached;
+  while(!reader.atEnd()) {
+    Function *f;
+    if (!reader.get(f)) {
+      return false; // should not happen with the same base module
+    }
+    cached.insert(f);
+  }
+  functions.insert(cached.begin(), cached.end());
+  return true;
+}
+
+void AnalysesCacheTy::putFunctions(Module *m, const std::string& section, const FunctionsSetTy& functions) {
+
+  if (!enabled(m)) {
+    return;
+  }
+  std::vector<std::string> names;
+  for(FunctionsSetTy::const_iterator fi = functions.begin(), fe = functions.end(); fi != fe; ++fi) {
+    Function *f = *fi;
+    if (isBaseFunction(f)) {
+      names.push_back(f->getName().str());
+    }
+  }
+  std::sort(names.begin(), names.end());
+
+  CacheWriterTy writer;
+  for(std::vector<std::string>::iterator ni = names.begin(), ne = names.end(); ni != ne; ++ni) {
+    writer.put(*ni);
+  }
+  put(m, section, writer.str());
+}
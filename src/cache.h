@@ -0,0 +1,120 @@
+#ifndef RCHK_CACHE_H
+#define RCHK_CACHE_H
+
+#include "common.h"
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+#include <llvm/IR/Module.h>
+
+using namespace llvm;
+
+// cache of analyses of the base module (R.bin.bc) kept on disk
+//   it is enabled using command line option of all tools
+//     --cache-dir DIR    directory for the cache files
+//
+//   the cache file is named by the MD5 hash of the contents of the base bitcode
+//   file, so a rebuilt base module gets a new cache
+//
+//   results are stored for functions (and global variables) of the base module
+//   only; when a package module is linked in, the cached results are used for
+//   the base functions and the analyses are only run for the functions of the
+//   package
+//     this is valid because base functions do not call package functions; the
+//     cache is not used when the package defines a function the base module only
+//     declares (the base would then be calling the package)
+//
+//   base functions and variables are identified by their objects, which the
+//   linker keeps; the results are stored by name, so the cache is not used
+//   when linking renamed a base function or variable (e.g. an internal one
+//   clashing with a package symbol), or when a package symbol took a name
+//   of the base
+//
+//   the analyses (errors.cpp, allocators.cpp, cprotect.cpp, callocators.cpp,
+//   symbols.cpp) store their results as named sections when they compute them;
+//   the file is replaced atomically, so that concurrent runs can share the cache
+//   directory
+
+// cached values, strings are length-prefixed so that they can hold any characters
+
+class CacheWriterTy {
+  std::string buf;
+
+  public:
+    void put(unsigned long n);
+    void put(const std::string& s);
+    void put(const Function *f);
+    const std::string& str() const { return buf; }
+};
+
+class CacheReaderTy {
+  const std::string& buf;
+  size_t pos;
+  Module *m;
+
+  public:
+    CacheReaderTy(const std::string& buf, Module *m): buf(buf), pos(0), m(m) {};
+
+    bool get(unsigned long& n);
+    bool get(std::string& s);
+    bool get(Function*& f); // fails when the module has no such function
+    bool atEnd() const { return pos == buf.size(); }
+};
+
+class AnalysesCacheTy {
+  std::string dir; // empty means no caching
+  std::string fileName;
+  Module *module; // the base module, possibly with a package linked in
+  bool linked;
+  bool valid;
+  std::unordered_set<std::string> baseFunctionNames; // defined or declared in the base module
+  std::unordered_set<std::string> baseDeclarationNames;
+  std::unordered_map<const GlobalValue*, std::string> baseNames; // functions and global variables of the base, before linking
+  FunctionsSetTy baseFunctions;
+  std::unordered_set<std::string> baseGlobalNames; // global variables
+  std::unordered_set<const GlobalVariable*> baseGlobals;
+
+  bool loaded;
+  std::string loadedVersion; // of the file when loaded
+  std::map<std::string, std::string> sections;
+  std::mutex mutex; // protects loaded, loadedVersion and sections
+
+  void loadFile();
+  void writeFile();
+  bool checkLinkedName(const GlobalValue *gv, const std::unordered_set<std::string>& names);
+
+  public:
+    AnalysesCacheTy(): dir(), fileName(), module(NULL), linked(false), valid(false), baseFunctionNames(), baseDeclarationNames(),
+      baseNames(), baseFunctions(), baseGlobalNames(), baseGlobals(), loaded(false), loadedVersion(), sections(), mutex() {};
+
+    void setDir(const std::string& dir) { this->dir = dir; }
+    bool hasDir() const { return !dir.empty(); }
+    void setBase(Module *base, const std::string& baseFname); // before a package is linked in
+    void setLinked(); // after a package has been linked in
+    void reload(); // reads sections stored by other processes, if any (before forking checks of modules, see batch.h)
+
+    bool enabled(Module *m) const { return valid && m == module; }
+    bool isLinked() const { return linked; }
+    bool isBaseFunction(Function *f) const { return baseFunctions.find(f) != baseFunctions.end(); }
+    bool isBaseGlobal(GlobalVariable *gv) const { return baseGlobals.find(gv) != baseGlobals.end(); }
+
+    bool get(Module *m, const std::string& section, std::string& payload);
+    void put(Module *m, const std::string& section, const std::string& payload); // only base results should be stored
+
+    // results of analyses that are sets of functions
+    //   get fills in the cached base functions, the package functions (if any) still have to be analyzed
+    bool getFunctions(Module *m, const std::string& section, FunctionsSetTy& functions);
+    void putFunctions(Module *m, const std::string& section, const FunctionsSetTy& functions);
+
+    void getPackageFunctions(FunctionsVectorTy& functions);
+};
+
+extern AnalysesCacheTy analysesCache;
+
+bool extractCacheOptions(int& argc, char* argv[]); // false on invalid options
+
+#endif
@@ -1,16 +1,23 @@
 
 #include "callocators.h"
+#include "budget.h"
+#include "cache.h"
 #include "errors.h"
 #include "guards.h"
 #include "symbols.h"
 #include "linemsg.h"
+#include "spill.h"
 #include "state.h"
 #include "table.h"
+#include "worklist.h"
 #include "exceptions.h"
 #include "patterns.h"
 
+#include <chrono>
+#include <condition_variable>
 #include <map>
-#include <stack>
+#include <thread>
+#include <unordered_map>
 #include <unordered_set>
 
 #include <llvm/IR/CallSite.h>
@@ -24,7 +31,7 @@ using namespace llvm;
 const bool DEBUG = false;
 const bool TRACE = false;
 const bool UNIQUE_MSG = true;
-const int MAX_STATES = CALLOCATORS_MAX_STATES;
+const unsigned long MAX_STATES = 1000000; // default, see --max-allocator-states
 const bool VERBOSE_DUMP = false;
 
 const bool DUMP_STATES = false;
@@ -99,6 +106,7 @@ bool CalledFunctionTy_equal::operator() (const CalledFunctionTy& lhs, const Call
 }
 
 SymbolArgInfoTy::SymbolArgInfoTableTy SymbolArgInfoTy::table;
+std::mutex SymbolArgInfoTy::tableMutex;
 
 size_t ArgInfosVectorTy_hash::operator()(const ArgInfosVectorTy& t) const {
   size_t res = 0;
@@ -121,13 +129,47 @@ size_t ArgInfosVectorTy_hash::operator()(const ArgInfosVectorTy& t) const {
   return res;
 }
 
+thread_local CalledFunctionsRecordTy* CalledModuleTy::recorder = NULL;
+
+const CalledFunctionTy* CalledModuleTy::intern(const CalledFunctionTy& calledFunction) {
+  size_t nBefore = newCalledFunctionHook ? calledFunctionsTable.size() : 0;
+  const CalledFunctionTy* cf = calledFunctionsTable.intern(calledFunction);
+  if (recorder) {
+    recorder->interned.insert(cf);
+  }
+  if (newCalledFunctionHook && cf->idx >= nBefore) {
+    newCalledFunctionHook();
+  }
+  return cf;
+}
+
 const CalledFunctionTy* CalledModuleTy::getCalledFunction(Function *f) {
   size_t nargs = f->arg_size();
   ArgInfosVectorTy argInfos(nargs, NULL);
+  return getCalledFunction(f, argInfos);
+}
+
+const CalledFunctionTy* CalledModuleTy::getCalledFunction(Function *f, const ArgInfosVectorTy& argInfos) {
   CalledFunctionTy calledFunction(f, intern(argInfos), this);
   return intern(calledFunction);
 }
 
+void CalledModuleTy::registerCallSite(Value *inst, const CalledFunctionTy *cf) {
+  if (recorder) {
+    recorder->callSites.push_back({inst, cf});
+  }
+  std::lock_guard<std::mutex> lock(internMutex);
+  auto csearch = callSiteTargets.find(inst);
+  if (csearch == callSiteTargets.end()) {
+    CalledFunctionsSetTy newSet;
+    newSet.insert(cf);
+    callSiteTargets.insert({inst, newSet});
+  } else {
+    CalledFunctionsSetTy& existingSet = csearch->second;
+    existingSet.insert(cf);
+  }
+}
+
 const CalledFunctionTy* CalledModuleTy::getCalledFunction(Value *inst, bool registerCallSite) {
   return getCalledFunction(inst, NULL, NULL, registerCallSite);
 }
@@ -187,19 +229,10 @@ const CalledFunctionTy* CalledModuleTy::getCalledFunction(Value *inst, SEXPGuard
     // not a symbol, leave argInfo as NULL
   }
       
-  CalledFunctionTy calledFunction(fun, intern(argInfo), this);
-  const CalledFunctionTy* cf = intern(calledFunction);
+  const CalledFunctionTy* cf = getCalledFunction(fun, argInfo);
   
   if (registerCallSite) {
-    auto csearch = callSiteTargets.find(inst);
-    if (csearch == callSiteTargets.end()) {
-      CalledFunctionsSetTy newSet;
-      newSet.insert(cf);
-      callSiteTargets.insert({inst, newSet});
-    } else {
-      CalledFunctionsSetTy& existingSet = csearch->second;
-      existingSet.insert(cf);
-    }
+    this->registerCallSite(inst, cf);
   }
   
   return cf;
@@ -209,7 +242,7 @@ CalledModuleTy::CalledModuleTy(Module *m, SymbolsMapTy *symbolsMap, FunctionsSet
   FunctionsSetTy* possibleAllocators, FunctionsSetTy* allocatingFunctions):
   
   m(m), symbolsMap(symbolsMap), errorFunctions(errorFunctions), globals(globals), possibleAllocators(possibleAllocators), allocatingFunctions(allocatingFunctions),
-  callSiteTargets(), vrfState(NULL), gcFunction(getCalledFunction(getGCFunction(m)))  {
+  callSiteTargets(), vrfState(NULL), internMutex(), newCalledFunctionHook(), gcFunction(getCalledFunction(getGCFunction(m)))  {
 
   for(Module::iterator fi = m->begin(), fe = m->end(); fi != fe; ++fi) {
     Function *fun = &*fi;
@@ -293,8 +326,11 @@ struct CalledFunctionsOSTableTy_hash {
 };
 
 typedef InterningTable<CalledFunctionsOrderedSetTy, CalledFunctionsOSTableTy_hash> CalledFunctionsOSTableTy;
+typedef InterningTable<PackedIntGuardsTy, PackedIntGuardsTy_hash> PackedIntGuardsTableTy;
+typedef InterningTable<PackedSEXPGuardsTy, PackedSEXPGuardsTy_hash> PackedSEXPGuardsTableTy;
 
 struct CAllocStateTy;
+struct CAllocExplorationTy;
 
 struct CAllocPackedStateTy : public PackedStateWithGuardsTy {
   const size_t hashcode;
@@ -302,12 +338,12 @@ struct CAllocPackedStateTy : public PackedStateWithGuardsTy {
   const InternedVarOriginsTy varOrigins;
   
   
-  CAllocPackedStateTy(size_t hashcode, BasicBlock* bb, const PackedIntGuardsTy& intGuards, const PackedSEXPGuardsTy& sexpGuards,
+  CAllocPackedStateTy(size_t hashcode, BasicBlock* bb, const PackedIntGuardsTy *intGuards, const PackedSEXPGuardsTy *sexpGuards,
     const InternedVarOriginsTy& varOrigins, const CalledFunctionsOrderedSetTy *called):
     
     PackedStateBaseTy(bb), PackedStateWithGuardsTy(bb, intGuards, sexpGuards), hashcode(hashcode), called(called), varOrigins(varOrigins)  {};
     
-  static CAllocPackedStateTy create(CAllocStateTy& us, IntGuardsChecker& intGuardsChecker, SEXPGuardsChecker& sexpGuardsChecker);
+  static CAllocPackedStateTy create(CAllocStateTy& us, CAllocExplorationTy& ex);
 };
 
 static VarOriginsTy unpackVarOrigins(const InternedVarOriginsTy& internedOrigins) {
@@ -323,9 +359,73 @@ static VarOriginsTy unpackVarOrigins(const InternedVarOriginsTy& internedOrigins
   return varOrigins;
 }
 
-static CalledFunctionsOSTableTy osTable; // interned ordered sets
+// the hashcode is cached at the time of first hashing
+//   (and indeed is not copied)
+
+struct CAllocPackedStateTy_hash {
+  size_t operator()(const CAllocPackedStateTy& t) const {
+    return t.hashcode;
+  }
+};
+
+struct CAllocPackedStateTy_equal {
+  bool operator() (const CAllocPackedStateTy& lhs, const CAllocPackedStateTy& rhs) const {
+    return lhs.bb == rhs.bb && lhs.intGuards == rhs.intGuards && lhs.sexpGuards == rhs.sexpGuards && 
+      lhs.varOrigins == rhs.varOrigins;
+  }
+};
+
+typedef StateWorkListTy<const CAllocPackedStateTy*> WorkListTy;
+typedef std::unordered_set<CAllocPackedStateTy, CAllocPackedStateTy_hash, CAllocPackedStateTy_equal> DoneSetTy;
+
+// a packed state spilled to disk (see spill.h)
+//   the origins are interned only when spilling (they are compared by pointers then)
+
+struct CAllocSpilledStateTy {
+  BasicBlock *bb;
+  const PackedIntGuardsTy *intGuards;
+  const PackedSEXPGuardsTy *sexpGuards;
+  const InternedVarOriginsTy *varOrigins;
+};
+
+struct InternedVarOriginsTy_hash {
+  size_t operator()(const InternedVarOriginsTy& t) const {
+    size_t res = 0;
+    hash_combine(res, t.size());
+    for(InternedVarOriginsTy::const_iterator oi = t.begin(), oe = t.end(); oi != oe; ++oi) {
+      hash_combine(res, (const void *) oi->first);
+      hash_combine(res, (const void *) oi->second); // interned
+    }
+    return res;
+  }
+};
+
+typedef InterningTable<InternedVarOriginsTy, InternedVarOriginsTy_hash> InternedVarOriginsTableTy;
+
+// state of exploring a single called function (getCalledAndWrappedFunctions)
+//   each thread computing the allocators has its own, the explored states
+//   and their interned components are not shared
+
+struct CAllocExplorationTy {
+  WorkListTy workList;
+  DoneSetTy doneSet;
+  SpilledStatesTy spilledStates; // explored states moved out of the done set
+  InternedVarOriginsTableTy spilledOriginsTable;
+  CalledFunctionsOSTableTy osTable; // interned ordered sets
+  PackedIntGuardsTableTy intGuardsTable; // interned packed guards
+  PackedSEXPGuardsTableTy sexpGuardsTable;
+  IntGuardsChecker* intGuardsChecker;
+  SEXPGuardsChecker* sexpGuardsChecker;
+  
+  CAllocExplorationTy(): workList(), doneSet(), spilledStates(sizeof(CAllocSpilledStateTy)),
+    spilledOriginsTable(), osTable(), intGuardsTable(), sexpGuardsTable(), intGuardsChecker(NULL), sexpGuardsChecker(NULL) {};
+    
+  InternedVarOriginsTy packVarOrigins(const VarOriginsTy& varOrigins);
+  CAllocSpilledStateTy spillRecord(const CAllocPackedStateTy& ps);
+  void clearStates();
+};
 
-static InternedVarOriginsTy packVarOrigins(const VarOriginsTy& varOrigins) {
+InternedVarOriginsTy CAllocExplorationTy::packVarOrigins(const VarOriginsTy& varOrigins) {
 
   InternedVarOriginsTy internedOrigins;
 
@@ -338,20 +438,38 @@ static InternedVarOriginsTy packVarOrigins(const VarOriginsTy& varOrigins) {
   return internedOrigins;
 }
 
+CAllocSpilledStateTy CAllocExplorationTy::spillRecord(const CAllocPackedStateTy& ps) {
+  CAllocSpilledStateTy record = { ps.bb, ps.intGuards, ps.sexpGuards, spilledOriginsTable.intern(ps.varOrigins) }; // no padding
+  return record;
+}
+
+void CAllocExplorationTy::clearStates() {
+  // clear the worklist and the doneset
+  doneSet.clear();
+  workList.clear();
+  spilledStates.clear();
+  spilledOriginsTable.clear();
+  osTable.clear();
+  intGuardsTable.clear();
+  sexpGuardsTable.clear();
+}
+
 struct CAllocStateTy : public StateWithGuardsTy {
   CalledFunctionsOrderedSetTy called;
   VarOriginsTy varOrigins;
+  CAllocExplorationTy& ex;
   
-  CAllocStateTy(const CAllocPackedStateTy& ps, IntGuardsChecker& intGuardsChecker, SEXPGuardsChecker& sexpGuardsChecker):
-    CAllocStateTy(ps.bb, intGuardsChecker.unpack(ps.intGuards), sexpGuardsChecker.unpack(ps.sexpGuards), *ps.called, unpackVarOrigins(ps.varOrigins)) {};
+  CAllocStateTy(const CAllocPackedStateTy& ps, CAllocExplorationTy& ex):
+    CAllocStateTy(ps.bb, ex.intGuardsChecker->unpack(*ps.intGuards), ex.sexpGuardsChecker->unpack(*ps.sexpGuards), *ps.called, unpackVarOrigins(ps.varOrigins), ex) {};
 
-  CAllocStateTy(BasicBlock *bb): StateBaseTy(bb), StateWithGuardsTy(bb), called(), varOrigins() {};
+  CAllocStateTy(BasicBlock *bb, CAllocExplorationTy& ex): StateBaseTy(bb), StateWithGuardsTy(bb), called(), varOrigins(), ex(ex) {};
 
-  CAllocStateTy(BasicBlock *bb, const IntGuardsTy& intGuards, const SEXPGuardsTy& sexpGuards, const CalledFunctionsOrderedSetTy& called, const VarOriginsTy& varOrigins):
-    StateBaseTy(bb), StateWithGuardsTy(bb, intGuards, sexpGuards), called(called), varOrigins(varOrigins) {};
+  CAllocStateTy(BasicBlock *bb, const IntGuardsTy& intGuards, const SEXPGuardsTy& sexpGuards, const CalledFunctionsOrderedSetTy& called, const VarOriginsTy& varOrigins,
+    CAllocExplorationTy& ex):
+    StateBaseTy(bb), StateWithGuardsTy(bb, intGuards, sexpGuards), called(called), varOrigins(varOrigins), ex(ex) {};
       
   virtual CAllocStateTy* clone(BasicBlock *newBB) {
-    return new CAllocStateTy(newBB, intGuards, sexpGuards, called, varOrigins);
+    return new CAllocStateTy(newBB, intGuards, sexpGuards, called, varOrigins, ex);
   }
     
   void dump(std::string dumpMsg) {
@@ -385,14 +503,14 @@ struct CAllocStateTy : public StateWithGuardsTy {
 };
 
 
-CAllocPackedStateTy CAllocPackedStateTy::create(CAllocStateTy& us, IntGuardsChecker& intGuardsChecker, SEXPGuardsChecker& sexpGuardsChecker) {
+CAllocPackedStateTy CAllocPackedStateTy::create(CAllocStateTy& us, CAllocExplorationTy& ex) {
 
-  InternedVarOriginsTy internedOrigins = packVarOrigins(us.varOrigins);
+  InternedVarOriginsTy internedOrigins = ex.packVarOrigins(us.varOrigins);
    
   size_t res = 0;
   hash_combine(res, us.bb);
-  intGuardsChecker.hash(res, us.intGuards);
-  sexpGuardsChecker.hash(res, us.sexpGuards);
+  ex.intGuardsChecker->hash(res, us.intGuards);
+  ex.sexpGuardsChecker->hash(res, us.sexpGuards);
     
   hash_combine(res, internedOrigins.size());
   for(InternedVarOriginsTy::const_iterator oi = internedOrigins.begin(), oe = internedOrigins.end(); oi != oe; ++oi) {
@@ -401,64 +519,46 @@ CAllocPackedStateTy CAllocPackedStateTy::create(CAllocStateTy& us, IntGuardsChec
     hash_combine(res, (const void *)srcs); // interned
   } // ordered map
     
-  return CAllocPackedStateTy(res, us.bb, intGuardsChecker.pack(us.intGuards), sexpGuardsChecker.pack(us.sexpGuards), internedOrigins, osTable.intern(us.called));
+  return CAllocPackedStateTy(res, us.bb, ex.intGuardsTable.intern(ex.intGuardsChecker->pack(us.intGuards)), ex.sexpGuardsTable.intern(ex.sexpGuardsChecker->pack(us.sexpGuards)),
+    internedOrigins, ex.osTable.intern(us.called));
 }
-  
-// the hashcode is cached at the time of first hashing
-//   (and indeed is not copied)
-
-struct CAllocPackedStateTy_hash {
-  size_t operator()(const CAllocPackedStateTy& t) const {
-    return t.hashcode;
-  }
-};
-
-struct CAllocPackedStateTy_equal {
-  bool operator() (const CAllocPackedStateTy& lhs, const CAllocPackedStateTy& rhs) const {
-    return lhs.bb == rhs.bb && lhs.intGuards == rhs.intGuards && lhs.sexpGuards == rhs.sexpGuards && 
-      lhs.varOrigins == rhs.varOrigins;
-  }
-};
-
-typedef std::stack<const CAllocPackedStateTy*> WorkListTy;
-typedef std::unordered_set<CAllocPackedStateTy, CAllocPackedStateTy_hash, CAllocPackedStateTy_equal> DoneSetTy;
-
-static WorkListTy workList; // FIXME: avoid these "globals"
-static DoneSetTy doneSet;   // FIXME: avoid these "globals"
-
-static IntGuardsChecker* intGuardsChecker; // FIXME: avoid these "globals"
-static SEXPGuardsChecker* sexpGuardsChecker; // FIXME: avoid these "globals"
-
 
 bool CAllocStateTy::add() {
 
-  CAllocPackedStateTy ps = CAllocPackedStateTy::create(*this, *intGuardsChecker, *sexpGuardsChecker);
+  CAllocExplorationTy& ex = this->ex;
+  CAllocPackedStateTy ps = CAllocPackedStateTy::create(*this, ex);
   delete this; // NOTE: state suicide
-  auto sinsert = doneSet.insert(ps);
+  if (ex.spilledStates.size()) {
+    CAllocSpilledStateTy record = ex.spillRecord(ps);
+    if (ex.spilledStates.contains(ps.hashcode, &record)) {
+      return false;
+    }
+  }
+  auto sinsert = ex.doneSet.insert(ps);
   if (sinsert.second) {
     const CAllocPackedStateTy* insertedState = &*sinsert.first;
-    workList.push(insertedState); // make the worklist point to the doneset
+    ex.workList.push(insertedState); // make the worklist point to the doneset
+    if (ex.spilledStates.shouldSpill(ex.doneSet.size())) {
+      ex.spilledStates.spill<CAllocSpilledStateTy>(ex.doneSet, ex.workList, [&ex](const CAllocPackedStateTy& ps, CAllocSpilledStateTy& record) {
+        record = ex.spillRecord(ps);
+      });
+    }
     return true;
   } else {
     return false;
   }
 }
 
-static void clearStates() { // FIXME: avoid copy paste (vs. bcheck)
-  // clear the worklist and the doneset
-  doneSet.clear();
-  WorkListTy empty;
-  std::swap(workList, empty);
-  osTable.clear();
-}
+// returns false when the exploration budget has been exceeded and the result is only a
+// context-insensitive approximation
 
-static void getCalledAndWrappedFunctions(const CalledFunctionTy *f, LineMessenger& msg, 
+static bool getCalledAndWrappedFunctions(const CalledFunctionTy *f, LineMessenger& msg, CAllocExplorationTy& ex,
   CalledFunctionsOrderedSetTy& called, CalledFunctionsOrderedSetTy& wrapped) {
 
   static const CalledFunctionTy* const externalFunctionMarker = new CalledFunctionTy(NULL, NULL, NULL);
   
   if (!f->fun || !f->fun->size()) {
-    return;
+    return true;
   }
   CalledModuleTy *cm = f->module;
     
@@ -488,23 +588,25 @@ static void getCalledAndWrappedFunctions(const CalledFunctionTy *f, LineMessenge
     }
   }
     
-  clearStates();
+  ex.clearStates();
+  ex.workList.start(f->fun);
   
   msg.newFunction(f->fun, " - " + funName(f));
-  intGuardsChecker = new IntGuardsChecker(&msg);
-  sexpGuardsChecker = new SEXPGuardsChecker(&msg, cm->getGlobals(), NULL /* possible allocators */, cm->getSymbolsMap(), f->argInfo, cm->getVrfState(), cm);
+  ex.intGuardsChecker = new IntGuardsChecker(&msg);
+  ex.sexpGuardsChecker = new SEXPGuardsChecker(&msg, cm->getGlobals(), NULL /* possible allocators */, cm->getSymbolsMap(), f->argInfo, cm->getVrfState(), cm);
   
   bool intGuardsEnabled = !avoidIntGuardsFor(f);
   bool sexpGuardsEnabled = !avoidSEXPGuardsFor(f);
   
   {
-    CAllocStateTy* initState = new CAllocStateTy(&f->fun->getEntryBlock());
+    CAllocStateTy* initState = new CAllocStateTy(&f->fun->getEntryBlock(), ex);
     initState->add();
   }
   
-  while(!workList.empty()) {
-    CAllocStateTy s(*workList.top(), *intGuardsChecker, *sexpGuardsChecker); // unpacks the state
-    workList.pop();    
+  ExplorationBudgetTy budget(explorationLimits.maxAllocatorStates, MAX_STATES);
+  while(!ex.workList.empty()) {
+    CAllocStateTy s(*ex.workList.top(), ex); // unpacks the state
+    ex.workList.pop();    
 
     if (DUMP_STATES && (DUMP_STATES_FUNCTION.empty() || DUMP_STATES_FUNCTION == f->getName())) {
       msg.trace("going to work on this state:", &*s.bb->begin());
@@ -520,11 +622,12 @@ static void getCalledAndWrappedFunctions(const CalledFunctionTy *f, LineMessenge
       continue;
     }
       
-    if (doneSet.size() > MAX_STATES) {
-      errs() << "ERROR: too many states (abstraction error?) in function " << funName(f) << "\n";
-      clearStates();
-      delete intGuardsChecker;
-      delete sexpGuardsChecker;
+    if (budget.exceeded(ex.doneSet.size() + ex.spilledStates.size())) {
+      // fall back to a context-insensitive approximation
+      errs() << "ERROR: " + budget.reason() + " (abstraction error?) in function " + funName(f) + "\n"; // in one piece, other threads may be reporting too
+      ex.clearStates();
+      delete ex.intGuardsChecker;
+      delete ex.sexpGuardsChecker;
       
       if (called.erase(externalFunctionMarker) > 0) {
         // the functions calls an external function
@@ -537,7 +640,7 @@ static void getCalledAndWrappedFunctions(const CalledFunctionTy *f, LineMessenge
       bool originAllocator = cm->isPossibleAllocator(f->fun);
         
       if (!originAllocating && !originAllocator) {
-        return;
+        return false;
       }
       for(inst_iterator ini = inst_begin(*f->fun), ine = inst_end(*f->fun); ini != ine; ++ini) {
         Instruction *in = &*ini;
@@ -576,7 +679,7 @@ static void getCalledAndWrappedFunctions(const CalledFunctionTy *f, LineMessenge
           }
         }
       }
-      return;
+      return false;
     }
       
     // process a single basic block
@@ -587,10 +690,10 @@ static void getCalledAndWrappedFunctions(const CalledFunctionTy *f, LineMessenge
       msg.trace("visiting", in);
    
       if (intGuardsEnabled) {
-        intGuardsChecker->handleForNonTerminator(in, s.intGuards);
+        ex.intGuardsChecker->handleForNonTerminator(in, s.intGuards);
       }
       if (sexpGuardsEnabled) {
-        sexpGuardsChecker->handleForNonTerminator(in, s.sexpGuards);
+        ex.sexpGuardsChecker->handleForNonTerminator(in, s.sexpGuards);
       }
         
       // handle stores
@@ -637,7 +740,7 @@ static void getCalledAndWrappedFunctions(const CalledFunctionTy *f, LineMessenge
                   msg.debug("call through a pointer, asserting it may be allocating (marking as call to gc function) - assigned to " + varName(dst), dyn_cast<Instruction>(v));
                 tgt = cm->getCalledGCFunction();
               } else {
-                tgt = cm->getCalledFunction(v, sexpGuardsChecker, &s.sexpGuards, true);
+                tgt = cm->getCalledFunction(v, ex.sexpGuardsChecker, &s.sexpGuards, true);
                 if (tgt && !cm->isPossibleAllocator(tgt->fun)) {
                   tgt = NULL;
                 }
@@ -662,7 +765,7 @@ static void getCalledAndWrappedFunctions(const CalledFunctionTy *f, LineMessenge
         if (msg.debug()) msg.debug("call through a pointer, using the external function marker", in);
         tgt = externalFunctionMarker;
       } else {
-        tgt = cm->getCalledFunction(in, sexpGuardsChecker, &s.sexpGuards, true);
+        tgt = cm->getCalledFunction(in, ex.sexpGuardsChecker, &s.sexpGuards, true);
         if (tgt && !cm->isAllocating(tgt->fun)) {
           tgt = NULL;
         }
@@ -725,7 +828,7 @@ static void getCalledAndWrappedFunctions(const CalledFunctionTy *f, LineMessenge
             if (msg.debug()) msg.debug("returning value from external function, asserting it is from gc function", t);
             tgt = cm->getCalledGCFunction();
           } else {
-            tgt = cm->getCalledFunction(returnOperand, sexpGuardsChecker, &s.sexpGuards, true);
+            tgt = cm->getCalledFunction(returnOperand, ex.sexpGuardsChecker, &s.sexpGuards, true);
             if (tgt && !cm->isPossibleAllocator(tgt->fun)) {
               tgt = NULL;
             }
@@ -738,11 +841,11 @@ static void getCalledAndWrappedFunctions(const CalledFunctionTy *f, LineMessenge
       }
     }
 
-    if (sexpGuardsEnabled && sexpGuardsChecker->handleForTerminator(t, s)) {
+    if (sexpGuardsEnabled && ex.sexpGuardsChecker->handleForTerminator(t, s)) {
       continue;
     }
 
-    if (intGuardsEnabled && intGuardsChecker->handleForTerminator(t, s)) {
+    if (intGuardsEnabled && ex.intGuardsChecker->handleForTerminator(t, s)) {
       continue;
     }
       
@@ -757,9 +860,9 @@ static void getCalledAndWrappedFunctions(const CalledFunctionTy *f, LineMessenge
       }
     }
   }
-  clearStates();
-  delete intGuardsChecker;
-  delete sexpGuardsChecker;
+  ex.clearStates();
+  delete ex.intGuardsChecker;
+  delete ex.sexpGuardsChecker;
   
   if (trackOrigins && called.find(cm->getCalledGCFunction()) != called.end()) {
     // the GC function is an exception
@@ -772,9 +875,9 @@ static void getCalledAndWrappedFunctions(const CalledFunctionTy *f, LineMessenge
     // lets assume conservatively such function may allocate
     called.insert(cm->getCalledGCFunction());
   }
+  return true;
 }
 
-typedef std::vector<std::vector<bool>> BoolMatrixTy;
 typedef std::vector<unsigned> AdjacencyListRow;
 typedef std::vector<AdjacencyListRow> AdjacencyListTy;
 
@@ -782,17 +885,38 @@ static void resize(AdjacencyListTy& list, unsigned n) {
   list.resize(n);
 }
 
-static void resize(BoolMatrixTy& matrix, unsigned n) {
-  unsigned oldn = matrix.size();
-  if (n <= oldn) {
-    return;
+// find functions from which the target is reachable via at least one edge
+//   (reverse breadth-first search from the target)
+
+static void findReachingFunctions(const AdjacencyListTy& list, unsigned n, unsigned target, std::vector<bool>& reaching) {
+
+  AdjacencyListTy predecessors(n);
+  for(unsigned i = 0; i < n; i++) {
+    for(AdjacencyListRow::const_iterator ji = list[i].begin(), je = list[i].end(); ji != je; ++ji) {
+      predecessors[*ji].push_back(i);
+    }
   }
-  matrix.resize(n);
-  for (unsigned i = 0; i < n; i++) {
-    matrix[i].resize(n);
+
+  reaching.assign(n, false);
+  std::vector<unsigned> workList;
+  workList.push_back(target);
+  while(!workList.empty()) {
+    unsigned j = workList.back();
+    workList.pop_back();
+    for(AdjacencyListRow::const_iterator ii = predecessors[j].begin(), ie = predecessors[j].end(); ii != ie; ++ii) {
+      unsigned i = *ii;
+      if (!reaching[i]) {
+        reaching[i] = true;
+        workList.push_back(i);
+      }
+    }
   }
 }
 
+// the original computation of the full transitive closure, kept for comparison (--benchmark-closure)
+
+typedef std::vector<std::vector<bool>> BoolMatrixTy;
+
 static void buildClosure(BoolMatrixTy& mat, AdjacencyListTy& list, unsigned n) {
 
   bool added = true;
@@ -821,91 +945,410 @@ static void buildClosure(BoolMatrixTy& mat, AdjacencyListTy& list, unsigned n) {
   }
 }
 
-void CalledModuleTy::computeCalledAllocators() {
+static void benchmarkClosure(const AdjacencyListTy& list, unsigned n, unsigned target, const std::vector<bool>& reaching, const std::string& name) {
 
-  // find calls and variable origins for each called function
-  // then create a "callgraph" out of these
-  // and then compute call graph closure
-  //
-  // for performance, restrict variable origins to possible allocators
-  // and restrict calls to possibly allocating functions
+  auto start = std::chrono::steady_clock::now();
+  AdjacencyListTy closureList = list; // copy
+  BoolMatrixTy mat(n, std::vector<bool>(n));
+  for(unsigned i = 0; i < n; i++) {
+    for(AdjacencyListRow::const_iterator ji = list[i].begin(), je = list[i].end(); ji != je; ++ji) {
+      mat[i][*ji] = true;
+    }
+  }
+  buildClosure(mat, closureList, n);
+  auto closureDone = std::chrono::steady_clock::now();
+
+  std::vector<bool> reaching2;
+  findReachingFunctions(list, n, target, reaching2);
+  auto searchDone = std::chrono::steady_clock::now();
+
+  for(unsigned i = 0; i < n; i++) {
+    myassert(mat[i][target] == reaching[i]);
+  }
+  errs() << "Closure of " << name << " of " << n << " called functions: matrix " <<
+    std::chrono::duration<double>(closureDone - start).count() << "s, reverse search " <<
+    std::chrono::duration<double>(searchDone - closureDone).count() << "s\n";
+}
+
+// computes the called and wrapped functions of the called functions in allocatorJobs threads
+//   the called functions are taken in the order of their indexes; exploring a function
+//   may intern new called functions (new contexts), which get the next indexes and are
+//   hence queued for exploration as they appear
+//
+//   the computation is finished when all called functions have been explored and no
+//   thread is exploring (so no more can be interned)
+
+//
+//   with the analyses cache (see cache.h), the results of exploring called functions of the
+//   base module are taken from the cache; an entry also keeps the called functions interned
+//   and the call sites registered during the exploration, which are re-created from it
+//   (entries are only kept when the exploration did not run out of budget)
+
+typedef std::map<std::string, std::string> CachedExplorationsTy; // called function -> entry
+
+struct CalledAllocatorsComputationTy {
+  CalledModuleTy *cm;
   
-  if (possibleCAllocators && allocatingCFunctions) {
+  std::string cacheSection;
+  CachedExplorationsTy cachedExplorations; // not modified while exploring
+  
+  std::mutex mutex; // protects the fields below
+  std::condition_variable progress; // a function has been explored or a new one interned
+  unsigned next; // index of the next called function to explore
+  unsigned nExploring;
+  AdjacencyListTy callsList; // calls[i] - list of functions called by i
+  AdjacencyListTy wrapsList; // wraps[i] - list of functions wrapped by i
+  CachedExplorationsTy newExplorations; // to be added to the cache
+  
+  CalledAllocatorsComputationTy(CalledModuleTy *cm): cm(cm), cacheSection(), cachedExplorations(), mutex(), progress(), next(0), nExploring(0),
+    callsList(), wrapsList(), newExplorations() {};
+  
+  void loadCache();
+  void storeCache();
+  bool getCachedExploration(const CalledFunctionTy *f, const std::string& key, CalledFunctionsOrderedSetTy& called, CalledFunctionsOrderedSetTy& wrapped);
+  void addCachedExploration(const CalledFunctionTy *f, const std::string& key, const CalledFunctionsRecordTy& record,
+    const CalledFunctionsOrderedSetTy& called, const CalledFunctionsOrderedSetTy& wrapped);
+  void explore(const CalledFunctionTy *f, LineMessenger& msg, CAllocExplorationTy& ex, CalledFunctionsOrderedSetTy& called, CalledFunctionsOrderedSetTy& wrapped);
+  void worker();
+
+  // wakes up a thread waiting for a called function to explore
+  void newCalledFunction() {
+    {
+      std::lock_guard<std::mutex> lock(mutex); // the waiting thread checks the number of functions under the lock
+    }
+    progress.notify_one();
+  }
+};
+
+// a called function is stored as the function name and a token per argument
+//   "?" (nothing known), "V" (vector) or "S" followed by the symbol name
+
+static void putCalledFunction(CacheWriterTy& writer, const CalledFunctionTy *cf) {
+
+  writer.put(cf->fun);
+  writer.put(cf->argInfo->size());
+  for(ArgInfosVectorTy::const_iterator ai = cf->argInfo->begin(), ae = cf->argInfo->end(); ai != ae; ++ai) {
+    const ArgInfoTy *a = *ai;
+    if (a && a->isSymbol()) {
+      writer.put("S" + static_cast<const SymbolArgInfoTy*>(a)->symbolName);
+    } else if (a && a->isVector()) {
+      writer.put("V");
+    } else {
+      writer.put("?");
+    }
+  }
+}
+
+static const CalledFunctionTy* getCalledFunction(CacheReaderTy& reader, CalledModuleTy *cm) {
+
+  Function *fun;
+  unsigned long nargs;
+  if (!reader.get(fun) || !reader.get(nargs)) {
+    return NULL;
+  }
+  ArgInfosVectorTy argInfo(nargs, NULL);
+  for(unsigned i = 0; i < nargs; i++) {
+    std::string token;
+    if (!reader.get(token) || token.empty()) {
+      return NULL;
+    }
+    if (token[0] == 'S') {
+      argInfo[i] = SymbolArgInfoTy::create(token.substr(1));
+    } else if (token == "V") {
+      argInfo[i] = VectorArgInfoTy::get();
+    }
+  }
+  return cm->getCalledFunction(fun, argInfo);
+}
+
+static bool getCalledFunctions(CacheReaderTy& reader, CalledModuleTy *cm, CalledFunctionsOrderedSetTy& functions) {
+
+  unsigned long n;
+  if (!reader.get(n)) {
+    return false;
+  }
+  for(unsigned i = 0; i < n; i++) {
+    const CalledFunctionTy *cf = getCalledFunction(reader, cm);
+    if (!cf) {
+      return false;
+    }
+    functions.insert(cf);
+  }
+  return true;
+}
+
+static void putCalledFunctions(CacheWriterTy& writer, const CalledFunctionsOrderedSetTy& functions) {
+
+  writer.put(functions.size());
+  for(CalledFunctionsOrderedSetTy::const_iterator fi = functions.begin(), fe = functions.end(); fi != fe; ++fi) {
+    putCalledFunction(writer, *fi);
+  }
+}
+
+void CalledAllocatorsComputationTy::loadCache() {
+
+  Module *m = cm->getModule();
+  if (!analysesCache.enabled(m)) {
     return;
   }
+  // the results depend on the state limit (other limits make the exploration run out of budget, it is then not cached)
+  cacheSection = "calledAllocators:" + std::to_string(ExplorationBudgetTy(explorationLimits.maxAllocatorStates, MAX_STATES).getMaxStates());
   
-  possibleCAllocators = new CalledFunctionsSetTy();
-  allocatingCFunctions = new CalledFunctionsSetTy();
-  
-  LineMessenger msg(m->getContext(), DEBUG, TRACE, UNIQUE_MSG);
+  std::string payload;
+  if (!analysesCache.get(m, cacheSection, payload)) {
+    return;
+  }
+  CacheReaderTy reader(payload, m);
+  while(!reader.atEnd()) {
+    std::string key;
+    std::string entry;
+    if (!reader.get(key) || !reader.get(entry)) {
+      cachedExplorations.clear();
+      return;
+    }
+    cachedExplorations.insert({key, entry});
+  }
+}
+
+void CalledAllocatorsComputationTy::storeCache() {
+
+  if (newExplorations.empty()) {
+    return;
+  }
+  newExplorations.insert(cachedExplorations.begin(), cachedExplorations.end());
   
-  unsigned nfuncs = getNumberOfCalledFunctions(); // NOTE: nfuncs can increase during the checking
+  CacheWriterTy writer;
+  for(CachedExplorationsTy::iterator ei = newExplorations.begin(), ee = newExplorations.end(); ei != ee; ++ei) {
+    writer.put(ei->first);
+    writer.put(ei->second);
+  }
+  analysesCache.put(cm->getModule(), cacheSection, writer.str());
+}
+
+// entry: interned called functions, called functions, wrapped functions, registered call sites
+//   a call site is the index of the instruction in the function and the target
 
-  BoolMatrixTy callsMat(nfuncs, std::vector<bool>(nfuncs));  // calls[i][j] - function i calls function j
-  AdjacencyListTy callsList(nfuncs, AdjacencyListRow()); // calls[i] - list of functions called by i
-  BoolMatrixTy wrapsMat(nfuncs, std::vector<bool>(nfuncs));  // wraps[i][j] - function i wraps function j
-  AdjacencyListTy wrapsList(nfuncs, AdjacencyListRow()); // wraps[i] - list of functions wrapped by i
+bool CalledAllocatorsComputationTy::getCachedExploration(const CalledFunctionTy *f, const std::string& key,
+    CalledFunctionsOrderedSetTy& called, CalledFunctionsOrderedSetTy& wrapped) {
+
+  auto esearch = cachedExplorations.find(key);
+  if (esearch == cachedExplorations.end()) {
+    return false;
+  }
+  CacheReaderTy reader(esearch->second, cm->getModule());
+  CalledFunctionsOrderedSetTy interned;
+  CalledFunctionsOrderedSetTy cachedCalled;
+  CalledFunctionsOrderedSetTy cachedWrapped;
+  unsigned long nCallSites;
+  
+  if (!getCalledFunctions(reader, cm, interned) || !getCalledFunctions(reader, cm, cachedCalled) ||
+      !getCalledFunctions(reader, cm, cachedWrapped) || !reader.get(nCallSites)) {
+    return false;
+  }
   
-  for(unsigned i = 0; i < getNumberOfCalledFunctions(); i++) {
+  std::vector<Instruction*> instructions;
+  for(inst_iterator ii = inst_begin(*f->fun), ie = inst_end(*f->fun); ii != ie; ++ii) {
+    instructions.push_back(&*ii);
+  }
+  std::vector<std::pair<Value*, const CalledFunctionTy*>> callSites;
+  for(unsigned i = 0; i < nCallSites; i++) {
+    unsigned long instIndex;
+    if (!reader.get(instIndex) || instIndex >= instructions.size()) {
+      return false;
+    }
+    const CalledFunctionTy *cf = getCalledFunction(reader, cm);
+    if (!cf) {
+      return false;
+    }
+    callSites.push_back({instructions[instIndex], cf});
+  }
+  
+  for(std::vector<std::pair<Value*, const CalledFunctionTy*>>::iterator ci = callSites.begin(), ce = callSites.end(); ci != ce; ++ci) {
+    cm->registerCallSite(ci->first, ci->second);
+  }
+  called.insert(cachedCalled.begin(), cachedCalled.end());
+  wrapped.insert(cachedWrapped.begin(), cachedWrapped.end());
+  return true;
+}
 
-    const CalledFunctionTy *f = getCalledFunction(i);
-    if (!f->fun || !f->fun->size() || !isAllocating(f->fun)) {
-      continue;
+void CalledAllocatorsComputationTy::addCachedExploration(const CalledFunctionTy *f, const std::string& key, const CalledFunctionsRecordTy& record,
+    const CalledFunctionsOrderedSetTy& called, const CalledFunctionsOrderedSetTy& wrapped) {
+
+  std::unordered_map<Value*, unsigned> instIndexes;
+  unsigned idx = 0;
+  for(inst_iterator ii = inst_begin(*f->fun), ie = inst_end(*f->fun); ii != ie; ++ii) {
+    instIndexes.insert({&*ii, idx++});
+  }
+  
+  CacheWriterTy writer;
+  putCalledFunctions(writer, CalledFunctionsOrderedSetTy(record.interned.begin(), record.interned.end()));
+  putCalledFunctions(writer, called);
+  putCalledFunctions(writer, wrapped);
+  writer.put(record.callSites.size());
+  for(std::vector<std::pair<Value*, const CalledFunctionTy*>>::const_iterator ci = record.callSites.begin(), ce = record.callSites.end(); ci != ce; ++ci) {
+    auto isearch = instIndexes.find(ci->first);
+    if (isearch == instIndexes.end()) {
+      return; // not an instruction of the function, do not cache
     }
+    writer.put(isearch->second);
+    putCalledFunction(writer, ci->second);
+  }
+  
+  std::lock_guard<std::mutex> lock(mutex);
+  newExplorations.insert({key, writer.str()});
+}
+
+void CalledAllocatorsComputationTy::explore(const CalledFunctionTy *f, LineMessenger& msg, CAllocExplorationTy& ex,
+    CalledFunctionsOrderedSetTy& called, CalledFunctionsOrderedSetTy& wrapped) {
+
+  if (!f->fun || !f->fun->size() || !cm->isAllocating(f->fun)) {
+    return;
+  }
+  
+  if (cacheSection.empty() || !analysesCache.isBaseFunction(f->fun)) {
+    getCalledAndWrappedFunctions(f, msg, ex, called, wrapped);
+  } else {
+    CacheWriterTy keyWriter;
+    putCalledFunction(keyWriter, f);
+    const std::string& key = keyWriter.str();
     
-    CalledFunctionsOrderedSetTy called;
-    CalledFunctionsOrderedSetTy wrapped;
-    getCalledAndWrappedFunctions(f, msg, called, wrapped);
-    
-    if (DEBUG && called.size()) {
-      errs() << "\nDetected (possible allocators) called by function " << funName(f) << ":\n";
-      for(CalledFunctionsOrderedSetTy::const_iterator cfi = called.begin(), cfe = called.end(); cfi != cfe; ++cfi) {
-        const CalledFunctionTy *cf = *cfi;
-        errs() << "   " << funName(cf) << "\n";
+    if (!getCachedExploration(f, key, called, wrapped)) {
+      CalledFunctionsRecordTy record;
+      CalledModuleTy::record(&record);
+      bool complete = getCalledAndWrappedFunctions(f, msg, ex, called, wrapped);
+      CalledModuleTy::record(NULL);
+      if (complete) {
+        addCachedExploration(f, key, record, called, wrapped);
       }
     }
-    if (DEBUG && wrapped.size()) {
-      errs() << "\nDetected (possible allocators) wrapped by function " << funName(f) << ":\n";
-      for(CalledFunctionsOrderedSetTy::const_iterator cfi = wrapped.begin(), cfe = wrapped.end(); cfi != cfe; ++cfi) {
-        const CalledFunctionTy *cf = *cfi;
-        errs() << "   " << funName(cf) << "\n";
+  }
+    
+  if (DEBUG && called.size()) {
+    errs() << "\nDetected (possible allocators) called by function " << funName(f) << ":\n";
+    for(CalledFunctionsOrderedSetTy::const_iterator cfi = called.begin(), cfe = called.end(); cfi != cfe; ++cfi) {
+      const CalledFunctionTy *cf = *cfi;
+      errs() << "   " << funName(cf) << "\n";
+    }
+  }
+  if (DEBUG && wrapped.size()) {
+    errs() << "\nDetected (possible allocators) wrapped by function " << funName(f) << ":\n";
+    for(CalledFunctionsOrderedSetTy::const_iterator cfi = wrapped.begin(), cfe = wrapped.end(); cfi != cfe; ++cfi) {
+      const CalledFunctionTy *cf = *cfi;
+      errs() << "   " << funName(cf) << "\n";
+    }
+  }
+  if (DEBUG) {
+    FunctionsSetTy wrappedAllocators;
+    getWrappedAllocators(f->fun, wrappedAllocators, getGCFunction(cm->getModule()));
+    if (!wrappedAllocators.empty()) {
+      errs() << "\nSimple (possible allocators) wrapped by function " << funName(f) << ":\n";
+      for(FunctionsSetTy::iterator fi = wrappedAllocators.begin(), fe = wrappedAllocators.end(); fi != fe; ++fi) {
+        Function *sf = *fi;
+        errs() << "   " << funName(sf) << "\n";
       }
     }
-    if (DEBUG) {
-      FunctionsSetTy wrappedAllocators;
-      getWrappedAllocators(f->fun, wrappedAllocators, getGCFunction(m));
-      if (!wrappedAllocators.empty()) {
-        errs() << "\nSimple (possible allocators) wrapped by function " << funName(f) << ":\n";
-        for(FunctionsSetTy::iterator fi = wrappedAllocators.begin(), fe = wrappedAllocators.end(); fi != fe; ++fi) {
-          Function *sf = *fi;
-          errs() << "   " << funName(sf) << "\n";
-        }
+  }
+}
+
+void CalledAllocatorsComputationTy::worker() {
+
+  LineMessenger msg(cm->getModule()->getContext(), DEBUG, TRACE, UNIQUE_MSG);
+  CAllocExplorationTy ex;
+  
+  std::unique_lock<std::mutex> lock(mutex);
+  for(;;) {
+    if (next == cm->getNumberOfCalledFunctions()) {
+      if (!nExploring) {
+        break;
       }
+      progress.wait(lock); // for new called functions or the end
+      continue;
     }
     
-    nfuncs = getNumberOfCalledFunctions(); // get the current size
+    unsigned i = next++;
+    nExploring++;
+    lock.unlock();
+    
+    const CalledFunctionTy *f = cm->getCalledFunction(i);
+    CalledFunctionsOrderedSetTy called;
+    CalledFunctionsOrderedSetTy wrapped;
+    explore(f, msg, ex, called, wrapped);
+    
+    lock.lock();
+    nExploring--;
+    
+    unsigned nfuncs = cm->getNumberOfCalledFunctions(); // get the current size
     resize(callsList, nfuncs);
     resize(wrapsList, nfuncs);
-    resize(callsMat, nfuncs);
-    resize(wrapsMat, nfuncs);
     
     for(CalledFunctionsOrderedSetTy::const_iterator cfi = called.begin(), cfe = called.end(); cfi != cfe; ++cfi) {
       const CalledFunctionTy *cf = *cfi;
-      callsMat[f->idx][cf->idx] = true;
       callsList[f->idx].push_back(cf->idx);
     }
 
     for(CalledFunctionsOrderedSetTy::const_iterator wfi = wrapped.begin(), wfe = wrapped.end(); wfi != wfe; ++wfi) {
       const CalledFunctionTy *wf = *wfi;
-      wrapsMat[f->idx][wf->idx] = true;
       wrapsList[f->idx].push_back(wf->idx);
-    }    
+    }
+    progress.notify_all();
   }
+}
+
+void CalledModuleTy::computeCalledAllocators() {
+
+  // find calls and variable origins for each called function
+  // then create a "callgraph" out of these
+  // and then find functions from which the GC function is reachable
+  //
+  // for performance, restrict variable origins to possible allocators
+  // and restrict calls to possibly allocating functions
+  
+  if (possibleCAllocators && allocatingCFunctions) {
+    return;
+  }
+  
+  possibleCAllocators = new CalledFunctionsSetTy();
+  allocatingCFunctions = new CalledFunctionsSetTy();
   
-  // calculate transitive closure
+  computeVectorReturningFunctions(); // otherwise computed lazily, which would be racy with multiple threads
 
-  buildClosure(callsMat, callsList, nfuncs);
-  buildClosure(wrapsMat, wrapsList, nfuncs);
+  CalledAllocatorsComputationTy computation(this);
+  computation.loadCache();
+  
+  if (allocatorJobs > 1) {
+    newCalledFunctionHook = [&computation]() { computation.newCalledFunction(); }; // so that idle threads pick it up right away
+    std::vector<std::thread> workers;
+    for(unsigned i = 0; i < allocatorJobs; i++) {
+      workers.push_back(std::thread(&CalledAllocatorsComputationTy::worker, &computation));
+    }
+    for(unsigned i = 0; i < allocatorJobs; i++) {
+      workers[i].join();
+    }
+    newCalledFunctionHook = nullptr;
+  } else {
+    computation.worker();
+  }
+  computation.storeCache();
+  
+  unsigned nfuncs = getNumberOfCalledFunctions();
+  AdjacencyListTy& callsList = computation.callsList;
+  AdjacencyListTy& wrapsList = computation.wrapsList;
+  resize(callsList, nfuncs);
+  resize(wrapsList, nfuncs);
+  
+  // calculate which functions (transitively) call or wrap the GC function
+  //   (only the column of the GC function is needed from the transitive closure)
+
+  unsigned gcidx = gcFunction->idx;
+  std::vector<bool> callsGC;
+  std::vector<bool> wrapsGC;
+  findReachingFunctions(callsList, nfuncs, gcidx, callsGC);
+  findReachingFunctions(wrapsList, nfuncs, gcidx, wrapsGC);
+
+  if (benchmarkClosures) {
+    benchmarkClosure(callsList, nfuncs, gcidx, callsGC, "calls");
+    benchmarkClosure(wrapsList, nfuncs, gcidx, wrapsGC, "wraps");
+  }
   
   // fill in results
   
@@ -915,16 +1358,15 @@ void CalledModuleTy::computeCalledAllocators() {
   contextSensitiveAllocatingFunctions = new FunctionsSetTy();
   contextSensitivePossibleAllocators = new FunctionsSetTy();
   
-  unsigned gcidx = gcFunction->idx;
   for(unsigned i = 0; i < nfuncs; i++) {
-    if (callsMat[i][gcidx]) {
+    if (callsGC[i]) {
       const CalledFunctionTy *tgt = getCalledFunction(i);
       allocatingCFunctions->insert(tgt);
       if (!tgt->hasContext()) {
         contextSensitiveAllocatingFunctions->insert(tgt->fun);
       }
     }
-    if (wrapsMat[i][gcidx]) {
+    if (wrapsGC[i]) {
       const CalledFunctionTy *tgt = getCalledFunction(i);
       if (!isKnownNonAllocator(tgt)) {
         possibleCAllocators->insert(tgt);
@@ -940,6 +1382,20 @@ void CalledModuleTy::computeCalledAllocators() {
   contextSensitivePossibleAllocators->insert(gcFunction->fun);
 }
 
+unsigned long allocatorJobs = 1;
+bool benchmarkClosures = false;
+
+bool extractAllocatorJobs(int& argc, char* argv[]) {
+
+  benchmarkClosures = extractFlag(argc, argv, "benchmark-closure");
+  std::string arg;
+  if (extractOption(argc, argv, "allocator-jobs", arg) && (!parseUnsigned(arg, allocatorJobs) || allocatorJobs == 0)) {
+    errs() << "Invalid number of jobs for computing allocators: " << arg << "\n";
+    return false;
+  }
+  return true;
+}
+
 std::string funName(const CalledFunctionTy *cf) {
   return funName(cf->fun) + cf->getNameSuffix();  
 }
@@ -6,11 +6,14 @@ class CalledModuleTy;
 
 #include "common.h"
 #include "allocators.h"
+#include "cow.h"
 #include "guards.h"
 #include "symbols.h"
 #include "table.h"
 #include "vectors.h"
 
+#include <functional>
+#include <mutex>
 #include <unordered_set>
 #include <vector>
 
@@ -51,8 +54,10 @@ struct SymbolArgInfoTy : public ArgInfoTy {
 
   typedef InterningTable<SymbolArgInfoTy, SymbolArgInfoTy_hash, SymbolArgInfoTy_equal> SymbolArgInfoTableTy;
   static SymbolArgInfoTableTy table;
+  static std::mutex tableMutex;
   
   static const SymbolArgInfoTy* create(const std::string& symbolName) {
+    std::lock_guard<std::mutex> lock(tableMutex);
     return table.intern(SymbolArgInfoTy(symbolName)); // FIXME: leaks memory  
   }
 };
@@ -98,7 +103,7 @@ struct CalledFunctionTy_equal {
   bool operator() (const CalledFunctionTy& lhs, const CalledFunctionTy& rhs) const;
 };    
 
-typedef IndexedInterningTable<CalledFunctionTy, CalledFunctionTy_hash, CalledFunctionTy_equal> CalledFunctionsTableTy;
+typedef ConcurrentIndexedInterningTable<CalledFunctionTy, CalledFunctionTy_hash, CalledFunctionTy_equal> CalledFunctionsTableTy;
 typedef std::vector<const CalledFunctionTy*> CalledFunctionsIndexTy;
 
 typedef std::set<const CalledFunctionTy*> CalledFunctionsOrderedSetTy; // for interned functions
@@ -117,13 +122,19 @@ typedef InterningTable<ArgInfosVectorTy, ArgInfosVectorTy_hash> ArgInfoVectorsTa
 
   // yikes, need forward type def
 struct SEXPGuardTy;
+struct SEXPGuardEntry_hash;
 class SEXPGuardsChecker;
-typedef std::map<AllocaInst*,SEXPGuardTy> SEXPGuardsTy;
+typedef SharedMapTy<AllocaInst*,SEXPGuardTy,SEXPGuardEntry_hash> SEXPGuardsTy;
 
 typedef std::map<Value*, CalledFunctionsSetTy> CallSiteTargetsTy;
 
+struct CalledFunctionsRecordTy { // called functions interned and call sites registered by a thread (see CalledModuleTy::record)
+  CalledFunctionsSetTy interned;
+  std::vector<std::pair<Value*, const CalledFunctionTy*>> callSites;
+};
+
 class CalledModuleTy {
-  CalledFunctionsTableTy calledFunctionsTable; // intern table
+  CalledFunctionsTableTy calledFunctionsTable; // intern table (thread-safe)
   ArgInfoVectorsTableTy argInfoVectorsTable; // intern table
   
   Module *m;
@@ -139,11 +150,16 @@ class CalledModuleTy {
   CallSiteTargetsTy callSiteTargets; // maps  call instruction -> set of target functions
   VrfStateTy* vrfState; // state for vector returning functions detection
   
+  std::mutex internMutex; // argInfoVectorsTable and callSiteTargets may be updated by multiple threads (bcheck --jobs, --allocator-jobs)
+  std::function<void()> newCalledFunctionHook; // when set, called after interning a new called function (see computeCalledAllocators)
+
   const CalledFunctionTy* const gcFunction;
+  
+  static thread_local CalledFunctionsRecordTy* recorder; // when set, called functions interned by the current thread are also recorded here
 
   private:
-    const ArgInfosVectorTy* intern(const ArgInfosVectorTy& argInfos) { return argInfoVectorsTable.intern(argInfos); }
-    const CalledFunctionTy* intern(const CalledFunctionTy& calledFunction) { return calledFunctionsTable.intern(calledFunction); }
+    const ArgInfosVectorTy* intern(const ArgInfosVectorTy& argInfos) { std::lock_guard<std::mutex> lock(internMutex); return argInfoVectorsTable.intern(argInfos); }
+    const CalledFunctionTy* intern(const CalledFunctionTy& calledFunction);
     void computeCalledAllocators();
 
   public:
@@ -156,9 +172,12 @@ class CalledModuleTy {
     const CalledFunctionTy* getCalledFunction(Value *inst, bool registerCallSite = false);
     const CalledFunctionTy* getCalledFunction(Value *inst, SEXPGuardsChecker *sexpGuardsChecker, SEXPGuardsTy *sexpGuards, bool registerCallSite); // takes context from guards
     const CalledFunctionTy* getCalledFunction(Function *f); // gets a version with no context
+    const CalledFunctionTy* getCalledFunction(Function *f, const ArgInfosVectorTy& argInfos); // gets a version with given context
+    void registerCallSite(Value *inst, const CalledFunctionTy *cf);
+    static void record(CalledFunctionsRecordTy* recorder) { CalledModuleTy::recorder = recorder; } // NULL stops recording
     const CalledFunctionTy* getCalledFunction(unsigned idx) { return calledFunctionsTable.at(idx); };
-    const CalledFunctionsIndexTy* getCalledFunctions() { return calledFunctionsTable.getIndex(); }
-    size_t getNumberOfCalledFunctions() { return calledFunctionsTable.getIndex()->size(); }
+    const CalledFunctionsIndexTy* getCalledFunctions() { return calledFunctionsTable.getIndex(); } // not while other threads may intern
+    size_t getNumberOfCalledFunctions() { return calledFunctionsTable.size(); }
     const CalledFunctionsSetTy* getPossibleCAllocators() { computeCalledAllocators(); return possibleCAllocators; }
     const CalledFunctionsSetTy* getAllocatingCFunctions() { computeCalledAllocators(); return allocatingCFunctions; }
     const CallSiteTargetsTy* getCallSiteTargets() { computeCalledAllocators(); return &callSiteTargets; }
@@ -186,4 +205,16 @@ class CalledModuleTy {
 
 std::string funName(const CalledFunctionTy *cf);
 
+// number of threads computing the called and wrapped functions of context-sensitive
+// allocators (computeCalledAllocators), set using command line option of all tools
+//   --allocator-jobs N
+//
+//   with option --benchmark-closure, the full transitive closure of the allocator
+//   call graphs (as computed originally) is also computed, checked to agree and the
+//   time taken by both is reported (see scripts/closure_bench.sh)
+
+extern unsigned long allocatorJobs;
+extern bool benchmarkClosures;
+bool extractAllocatorJobs(int& argc, char* argv[]); // false on invalid option
+
 #endif
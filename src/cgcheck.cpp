@@ -13,6 +13,7 @@
 
 #include "allocators.h"
 #include "cgclosure.h"
+#include "tools.h"
 
 using namespace llvm;
 
@@ -29,25 +30,21 @@ void getCalledFunctions(Function *f, FunctionsSetTy& calledFunctions) {
   }
 }
 
-int main(int argc, char* argv[])
+static int runCgcheck(ModuleAnalysesTy& analyses, FunctionsOrderedSetTy& functionsOfInterestSet, FunctionsVectorTy& functionsOfInterestVector)
 {
-  LLVMContext context;
-  FunctionsOrderedSetTy functionsOfInterestSet;
-  FunctionsVectorTy functionsOfInterestVector;
-  
-  Module *m = parseArgsReadIR(argc, argv, functionsOfInterestSet, functionsOfInterestVector, context);
+  Module *m = analyses.getModule();
 
   /* ignore Rf_error because it calls into Rf_errorcall */
   Function *errorf = m->getFunction("Rf_error");
   if (!errorf) {
     errs() << "Cannot find function to check.\n";
-    exit(1);
+    return 1;
   }
 
   Function *myf = m->getFunction("Rf_errorcall");
   if (!myf) {
     errs() << "Cannot find function to check.\n";
-    exit(1);
+    return 1;
   }
   
   FunctionsSetTy onlyFunctions;
@@ -76,7 +73,7 @@ int main(int argc, char* argv[])
   auto fsearch = functionsMap.find(myf);
   if (fsearch == functionsMap.end()) {
     errs() << "Cannot find function info of function to check\n";
-    exit(1);
+    return 1;
   }
   myfindex = fsearch->second.index;  
 
@@ -91,6 +88,14 @@ int main(int argc, char* argv[])
       errs() << funName(finfo.function) << "\n";
     }
   }
+  return 0;
+}
 
-  delete m;
+const ToolTy cgcheckTool = {"cgcheck", NULL, runCgcheck, false, false};
+
+#ifndef RCHK_DRIVER
+int main(int argc, char* argv[])
+{
+  return runTool(cgcheckTool, argc, argv);
 }
+#endif
@@ -2,6 +2,8 @@
 #include "cgclosure.h"
 #include "errors.h"
 
+#include <climits>
+
 #include <llvm/Analysis/CallGraph.h>
 
 #include <llvm/Support/raw_ostream.h>
@@ -10,6 +12,75 @@ using namespace llvm;
 
 const bool DEBUG = false;
 
+// find strongly connected components of the graph of direct calls (calledFunctionsList)
+//   (iterative version of Tarjan's algorithm)
+//   the components are found in reverse topological order: a component is found
+//   only after all components it calls
+
+static void findStronglyConnectedComponents(const std::vector<FunctionInfo*>& infos, std::vector<unsigned>& sccOf, std::vector<std::vector<unsigned>>& sccs) {
+
+  const unsigned NOT_VISITED = UINT_MAX;
+  unsigned n = infos.size();
+  
+  std::vector<unsigned> order(n, NOT_VISITED);
+  std::vector<unsigned> lowlink(n);
+  std::vector<bool> onStack(n, false);
+  std::vector<unsigned> stack;
+  std::vector<std::pair<unsigned, unsigned>> dfs; // function, index of the next call to follow
+  unsigned counter = 0;
+
+  sccOf.assign(n, NOT_VISITED);
+  sccs.clear();
+  
+  for(unsigned root = 0; root < n; root++) {
+    if (order[root] != NOT_VISITED) {
+      continue;
+    }
+    order[root] = lowlink[root] = counter++;
+    stack.push_back(root);
+    onStack[root] = true;
+    dfs.push_back({root, 0});
+    
+    while(!dfs.empty()) {
+      unsigned v = dfs.back().first;
+      const std::vector<FunctionInfo*>& targets = infos[v]->calledFunctionsList;
+      
+      if (dfs.back().second < targets.size()) {
+        unsigned w = targets[dfs.back().second++]->index;
+        if (order[w] == NOT_VISITED) {
+          order[w] = lowlink[w] = counter++;
+          stack.push_back(w);
+          onStack[w] = true;
+          dfs.push_back({w, 0});
+        } else if (onStack[w] && order[w] < lowlink[v]) {
+          lowlink[v] = order[w];
+        }
+        continue;
+      }
+      
+      dfs.pop_back();
+      if (!dfs.empty()) {
+        unsigned u = dfs.back().first;
+        if (lowlink[v] < lowlink[u]) {
+          lowlink[u] = lowlink[v];
+        }
+      }
+      if (lowlink[v] == order[v]) {
+        unsigned s = sccs.size();
+        sccs.push_back(std::vector<unsigned>());
+        unsigned w;
+        do {
+          w = stack.back();
+          stack.pop_back();
+          onStack[w] = false;
+          sccOf[w] = s;
+          sccs[s].push_back(w);
+        } while (w != v);
+      }
+    }
+  }
+}
+
 // build closure over the callgraph of module m
 // each function from module m gets its FunctionInfo in the functionsMap
 
@@ -31,19 +102,6 @@ void buildCGClosure(Module *m, FunctionsInfoMapTy& functionsMap, bool ignoreErro
   unsigned long edges = 0;
   unsigned long functions = 0;
   
-  // count (maximum) number of functions that will be stored in calledFunctionsMap (also a bound for function index)
-  unsigned long maxFunctions = 0;
-  
-  for (CallGraph::const_iterator MI = cg->begin(), ME = cg->end(); MI != ME; ++MI) {
-    Function* fun = const_cast<Function*>(MI->first);
-    if (!fun) continue;
-    
-    if (onlyFunctions && onlyFunctions->find(fun) == onlyFunctions->end()) {
-      continue;
-    }
-    maxFunctions++;
-  }
-     
   for (CallGraph::const_iterator MI = cg->begin(), ME = cg->end(); MI != ME; ++MI) {
     Function* fun = const_cast<Function*>(MI->first);
     const CallGraphNode* sourceCGN = MI->second.get();
@@ -56,7 +114,7 @@ void buildCGClosure(Module *m, FunctionsInfoMapTy& functionsMap, bool ignoreErro
     FunctionInfo *finfo;
     auto fsearch = functionsMap.find(fun);
     if (fsearch == functionsMap.end()) {
-      auto insert = functionsMap.insert({fun, FunctionInfo(fun, functions++, maxFunctions)});
+      auto insert = functionsMap.insert({fun, FunctionInfo(fun, functions++)});
       finfo = &insert.first->second;
     } else {
       finfo = &fsearch->second;
@@ -111,7 +169,7 @@ void buildCGClosure(Module *m, FunctionsInfoMapTy& functionsMap, bool ignoreErro
       auto search = functionsMap.find(targetFun);
       if (search == functionsMap.end()) {
         if (DEBUG) errs() << " creating new info";
-        auto insert = functionsMap.insert({targetFun, FunctionInfo(targetFun, functions++, maxFunctions)});
+        auto insert = functionsMap.insert({targetFun, FunctionInfo(targetFun, functions++)});
         targetFunctionInfo = &insert.first->second;
         
       } else {
@@ -146,62 +204,72 @@ void buildCGClosure(Module *m, FunctionsInfoMapTy& functionsMap, bool ignoreErro
     if (DEBUG) errs() << " mapped function " << funName(finfo->function) << "\n";
   }
   
-  // fill-in bitmaps of which functions are reachable from which - now we know the number of functions to do that
-  
-  if (DEBUG) errs() << "Allocating bitmaps and registering functions.\n";
+  // compute transitive closure
+  //
+  // functions of a strongly connected component call the same functions, so the
+  // closure is computed for the components, in reverse topological order: a component
+  // calls the direct targets of its functions and all that these targets call
+  //
+  // calledFunctionsList holds the direct targets until here
+
+  if (DEBUG) errs() << "The graph has " << functions << " nodes and " << edges << " edges.\n";
 
+  std::vector<FunctionInfo*> infos(functions);
   for(FunctionsInfoMapTy::iterator FI = functionsMap.begin(), FE = functionsMap.end(); FI != FE; ++FI) {
     FunctionInfo& finfo = FI->second;
-    
-    for(std::vector<FunctionInfo*>::iterator TFI = finfo.calledFunctionsList.begin(), TFE = finfo.calledFunctionsList.end(); TFI != TFE; ++TFI) {
-      FunctionInfo *targetFinfo = *TFI;
-          
-      (finfo.callsFunctionMap)[targetFinfo->index] = true; 
-    }
+    infos[finfo.index] = &finfo;
   }
+
+  std::vector<unsigned> sccOf;
+  std::vector<std::vector<unsigned>> sccs;
+  findStronglyConnectedComponents(infos, sccOf, sccs);
   
-  // compute transitive closure
-  // no attempts were made to make this efficient
-  //     
-  // for each function node (function info)
-  //   for each call instruction (call info)
-  //     add targets reachable through 1 intermediate call to this call info
-  //
-  // repeat the above as long as at least one target has actually been added
-  
-  if (DEBUG) errs() << "Calculating transitive closure.\n";
-  int iterations = 0;
-  if (DEBUG) errs() << "The graph has " << functions << " nodes and " << edges << " edges.\n";
+  if (DEBUG) errs() << "Calculating transitive closure over " << sccs.size() << " strongly connected components.\n";
+
+  unsigned nwords = (functions + 63) / 64;
+  unsigned nsccs = sccs.size();
+  std::vector<std::shared_ptr<const std::vector<uint64_t>>> sccCalls(nsccs);
+  std::vector<unsigned> mergedInto(nsccs, UINT_MAX); // last component into which the calls of a component were merged
   
-  for(unsigned long addedCalls = ULONG_MAX; addedCalls != 0; iterations++) {
-    addedCalls = 0;
-    unsigned long visitedCalls = 0;
-    unsigned long processedFunctions = 0;    
-    if (DEBUG) errs() << "Iteration " << iterations << "...";
-    for(FunctionsInfoMapTy::iterator FI = functionsMap.begin(), FE = functionsMap.end(); FI != FE; ++FI) {
-      FunctionInfo& finfo = FI->second;
-      processedFunctions++;
-      if (DEBUG && !(processedFunctions % (functions/10))) errs() << "#";
-      
-      std::vector<FunctionInfo*> toadd;
+  for(unsigned s = 0; s < nsccs; s++) {
+    std::shared_ptr<std::vector<uint64_t>> bits = std::make_shared<std::vector<uint64_t>>(nwords, 0);
+    
+    for(std::vector<unsigned>::iterator MI = sccs[s].begin(), ME = sccs[s].end(); MI != ME; ++MI) {
+      FunctionInfo *finfo = infos[*MI];
       
-      for(std::vector<FunctionInfo*>::iterator MFI = finfo.calledFunctionsList.begin(), MFE = finfo.calledFunctionsList.end(); MFI != MFE; ++MFI) {
-        FunctionInfo *middleFinfo = *MFI;
-          
-        for(std::vector<FunctionInfo*>::iterator TFI = middleFinfo->calledFunctionsList.begin(), TFE = middleFinfo->calledFunctionsList.end(); TFI != TFE; ++TFI) {
-          FunctionInfo *targetFinfo = *TFI;
-              
-          if (!(finfo.callsFunctionMap)[targetFinfo->index]) {
-            (finfo.callsFunctionMap)[targetFinfo->index] = true;
-            toadd.push_back(targetFinfo);
-            addedCalls++;
+      for(std::vector<FunctionInfo*>::iterator TFI = finfo->calledFunctionsList.begin(), TFE = finfo->calledFunctionsList.end(); TFI != TFE; ++TFI) {
+        unsigned t = (*TFI)->index;
+        (*bits)[t / 64] |= ((uint64_t) 1) << (t % 64);
+        
+        unsigned ts = sccOf[t];
+        if (ts != s && mergedInto[ts] != s) {
+          mergedInto[ts] = s;
+          const std::vector<uint64_t>& tbits = *sccCalls[ts]; // already computed
+          for(unsigned w = 0; w < nwords; w++) {
+            (*bits)[w] |= tbits[w];
           }
         }
       }
-      
-      finfo.calledFunctionsList.insert(finfo.calledFunctionsList.end(), toadd.begin(), toadd.end());
-    } 
-    if (DEBUG) errs() << " added " << addedCalls << " calls out of " << visitedCalls << " visited calls.\n";
+    }
+    sccCalls[s] = bits;
+  }
+  
+  // fill in the results
+  //   the list of called functions is built once per component, from the set bits
+  
+  for(unsigned s = 0; s < nsccs; s++) {
+    const std::shared_ptr<const std::vector<uint64_t>>& bits = sccCalls[s];
+    std::vector<FunctionInfo*> called;
+    for(unsigned w = 0; w < nwords; w++) {
+      for(uint64_t word = (*bits)[w]; word; word &= word - 1) {
+        called.push_back(infos[w * 64 + __builtin_ctzll(word)]);
+      }
+    }
+    for(std::vector<unsigned>::iterator MI = sccs[s].begin(), ME = sccs[s].end(); MI != ME; ++MI) {
+      FunctionInfo *finfo = infos[*MI];
+      finfo->callsFunctionMap = CalledFunctionsMapTy(bits);
+      finfo->calledFunctionsList = called;
+    }
   }
   delete cg;
 }
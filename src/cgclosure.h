@@ -3,7 +3,9 @@
 
 #include "common.h"
 
+#include <cstdint>
 #include <map>
+#include <memory>
 #include <set>
 #include <vector>
 
@@ -22,15 +24,31 @@ struct CallInfo {
   CallInfo(const Instruction* instruction, const FunctionInfo* target): instruction(instruction), target(target) {};
 };
 
+// which functions (by index) are (transitively) called by a function
+//   the bitset is shared by all functions of a strongly connected component
+//   of the call graph, as they all call the same functions
+
+class CalledFunctionsMapTy {
+  std::shared_ptr<const std::vector<uint64_t>> bits; // NULL means no function is called
+  
+  public:
+  CalledFunctionsMapTy(): bits() {};
+  CalledFunctionsMapTy(const std::shared_ptr<const std::vector<uint64_t>>& bits): bits(bits) {};
+  
+  bool operator[](unsigned index) const {
+    return bits && (((*bits)[index / 64] >> (index % 64)) & 1);
+  }
+};
+
 struct FunctionInfo {  
   const Function* const function;
   std::vector<CallInfo> callInfos;
-  std::vector<bool> callsFunctionMap;
-  std::vector<FunctionInfo*> calledFunctionsList;
+  CalledFunctionsMapTy callsFunctionMap;
+  std::vector<FunctionInfo*> calledFunctionsList; // all (transitively) called functions
   const unsigned index;
   
   public:
-  FunctionInfo(const Function* const f, unsigned long index, unsigned long maxFunctions): function(f), callInfos(), callsFunctionMap(maxFunctions, false), index(index) {};
+  FunctionInfo(const Function* const f, unsigned long index): function(f), callInfos(), callsFunctionMap(), index(index) {};
 };
 
 typedef std::map<Function*, FunctionInfo> FunctionsInfoMapTy;
@@ -1,7 +1,17 @@
 
 #include "common.h"
+#include "batch.h"
+#include "budget.h"
+#include "cache.h"
+#include "callocators.h"
+#include "lazy.h"
+#include "server.h"
+#include "shard.h"
+#include "worklist.h"
+#include "spill.h"
 
 #include <cxxabi.h>
+#include <mutex>
 #include <vector>
 
 #include <llvm/IR/BasicBlock.h>
@@ -60,10 +70,36 @@ void sortFunctionsByName(FunctionsOrderedSetTy& functionsOfInterestSet, Function
 //     from that module (but some tools need to do whole-program analysis
 //     which also will include functions from the base
 //      IR file not included in the module)
+//
+//   tool --batch list path/R.bin.bc
+//     as above for each module in the list, each with its own output file
+//     (see batch.h)
+//   tool --server socket path/R.bin.bc
+//     as above for each module requested through the socket (see server.h)
+//
+//   options --max-states, --max-allocator-states, --max-time and --max-memory set limits for
+//   exploring states of individual functions (see budget.h), option
+//   --worklist sets the order in which the states are explored (see worklist.h),
+//   options --spill-dir and --spill-states enable keeping explored states on
+//   disk (see spill.h), option --allocator-jobs sets the number of threads
+//   computing context-sensitive allocators and option --benchmark-closure times
+//   their transitive closure (see callocators.h), option
+//   --cache-dir enables keeping analyses of the base module on disk (see cache.h),
+//   option --lazy enables reading bodies of base functions only when needed
+//   (see lazy.h), option --shard selects a part of the functions of interest
+//   to check (see shard.h, the part is selected by runTool)
 Module *parseArgsReadIR(int argc, char* argv[], FunctionsOrderedSetTy& functionsOfInterestSet, FunctionsVectorTy& functionsOfInterestVector, LLVMContext& context) {
 
-  if (argc > 3) {
-    errs() << argv[0] << " base_file.bc [module_file.bc]" << "\n";
+  if (!extractExplorationLimits(argc, argv) || !extractWorkListStrategy(argc, argv) || !extractSpillOptions(argc, argv) ||
+      !extractAllocatorJobs(argc, argv) || !extractCacheOptions(argc, argv) || !extractBatchOptions(argc, argv) ||
+      !extractServerOptions(argc, argv) || !extractLazyOptions(argc, argv) || !extractShardOptions(argc, argv) ||
+      (batchOptions.enabled() && serverOptions.enabled()) ||
+      argc > (batchOptions.enabled() || serverOptions.enabled() ? 2 : 3)) {
+    errs() << argv[0] << " [--max-states N] [--max-allocator-states N] [--max-time seconds] [--max-memory size] [--worklist dfs|rpo] [--spill-dir dir] [--spill-states N]"
+      << " [--allocator-jobs N] [--benchmark-closure] [--cache-dir dir] [--lazy] [--shard i/n]"
+      << " base_file.bc [module_file.bc]" << "\n";
+    errs() << argv[0] << " [options] --batch list_file base_file.bc" << "\n";
+    errs() << argv[0] << " [options] --server socket [--server-jobs N] base_file.bc" << "\n";
     exit(1);
   }
 
@@ -76,25 +112,33 @@ Module *parseArgsReadIR(int argc, char* argv[], FunctionsOrderedSetTy& functions
     baseFname = argv[1];
   }
   
-  Module* base = parseIRFile(baseFname, error, context).release();
+  Module* base = readBaseModule(baseFname, error, context);
   if (!base) {
     errs() << "ERROR: Cannot read base IR file " << baseFname << "\n";
     error.print(argv[0], errs());
     exit(1);
   }
+  analysesCache.setBase(base, baseFname);
   
-  if (argc == 1 || argc == 2) {
+  std::string moduleFname;
+  if (batchOptions.enabled()) {
+    runBatch(base, baseFname, moduleFname); // returns in a process for a single module
+  } else if (serverOptions.enabled()) {
+    runServer(base, baseFname, moduleFname); // returns in a process for a single module
+  } else if (argc == 1 || argc == 2) {
     // only a single input file
+    materializeModule(base);
     for(Module::iterator f = base->begin(), fe = base->end(); f != fe; ++f) {
       Function *fun = &*f;
       functionsOfInterestSet.insert(fun);
     }
     sortFunctionsByName(functionsOfInterestSet, functionsOfInterestVector);
     return base;
+  } else {
+    moduleFname = argv[2];
   }
   
   // have two input files
-  std::string moduleFname = argv[2];
   std::unique_ptr<Module> module = parseIRFile(moduleFname, error, context);
   if (!module) {
     errs() << "ERROR: Cannot read module IR file " << moduleFname << "\n";
@@ -126,6 +170,7 @@ Module *parseArgsReadIR(int argc, char* argv[], FunctionsOrderedSetTy& functions
   if (Linker::linkModules(*base, move(module))) {
     errs() << "Linking module " << moduleFname << " with base " << baseFname << " resulted in an error.\n";
   }
+  analysesCache.setLinked();
   
   for(std::vector<std::string>::iterator ni = functionNames.begin(), ne = functionNames.end(); ni != ne; ++ni) {
     std::string name = *ni;
@@ -137,10 +182,65 @@ Module *parseArgsReadIR(int argc, char* argv[], FunctionsOrderedSetTy& functions
     // in package tau), but R has the same symbol as non-function
   }
 
+  materializeReachable(base, functionsOfInterestSet);
+
   sortFunctionsByName(functionsOfInterestSet, functionsOfInterestVector);
   return base;
 }
 
+// extracts option "--name value" or "--name=value" from the command line
+//   the option is removed from argv, so that the remaining (positional)
+//   arguments can then be passed to parseArgsReadIR
+bool extractOption(int& argc, char* argv[], const std::string& name, std::string& value) {
+
+  std::string opt = "--" + name;
+  for(int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    int nremove;
+    
+    if (arg == opt && i + 1 < argc) {
+      value = argv[i + 1];
+      nremove = 2;
+    } else if (arg.compare(0, opt.size() + 1, opt + "=") == 0) {
+      value = arg.substr(opt.size() + 1);
+      nremove = 1;
+    } else {
+      continue;
+    }
+    for(int j = i; j + nremove <= argc; j++) { // including the terminating NULL
+      argv[j] = argv[j + nremove];
+    }
+    argc -= nremove;
+    return true;
+  }
+  return false;
+}
+
+bool extractFlag(int& argc, char* argv[], const std::string& name) {
+
+  std::string opt = "--" + name;
+  for(int i = 1; i < argc; i++) {
+    if (opt != argv[i]) {
+      continue;
+    }
+    for(int j = i; j + 1 <= argc; j++) { // including the terminating NULL
+      argv[j] = argv[j + 1];
+    }
+    argc--;
+    return true;
+  }
+  return false;
+}
+
+bool parseUnsigned(const std::string& str, unsigned long& value) {
+  if (str.empty() || !isdigit(str[0])) {
+    return false;
+  }
+  char *end;
+  value = strtoul(str.c_str(), &end, 10);
+  return *end == 0;
+}
+
 std::string demangle(std::string name) {
   int status;
   char *dname = abi::__cxa_demangle(name.c_str(), 0, 0, &status);
@@ -243,6 +343,8 @@ std::string computeVarName(const AllocaInst *var) {
 std::string varName(const AllocaInst *var) {
 
   static VarNamesTy cache;
+  static std::mutex cacheMutex; // bcheck checks functions in parallel
+  std::lock_guard<std::mutex> lock(cacheMutex);
   
   auto vsearch = cache.find(var);
   if (vsearch != cache.end()) {
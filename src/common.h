@@ -45,6 +45,10 @@ typedef std::unordered_map<AllocaInst*,bool,VarBoolCacheTy_hash> VarBoolCacheTy;
 
 Module *parseArgsReadIR(int argc, char* argv[], FunctionsOrderedSetTy& functionsOfInterestSet, FunctionsVectorTy& functionsOfInterestVector, LLVMContext& context);
 
+bool extractOption(int& argc, char* argv[], const std::string& name, std::string& value);
+bool extractFlag(int& argc, char* argv[], const std::string& name); // option without a value
+bool parseUnsigned(const std::string& str, unsigned long& value);
+
 std::string demangle(std::string name);
 
 bool sourceLocation(const Instruction *in, std::string& path, unsigned& line);
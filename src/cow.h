@@ -0,0 +1,211 @@
+#ifndef RCHK_COW_H
+#define RCHK_COW_H
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <vector>
+
+// copy-on-write wrappers of std::map and std::vector, used for components
+// of states (guards, fresh variables, ...)
+//
+//   copies share the underlying container until one of them is modified,
+//   so copying a state into its successors is cheap and only components
+//   the successor actually changes get copied
+//
+//   iterators are always const; modifications go through the modifying
+//   operations below (or modify(), which exposes the unshared container)
+//   iterators obtained before a modification may point to the (still
+//   shared) old container
+//
+//   the wrappers also keep a hash of the contents, which is the xor of the
+//   hashes of the individual entries (Zobrist hashing), so that it can be
+//   updated in constant time on each modification; after modify(), the hash
+//   is recomputed when needed
+
+// spread the bits of a hash of an entry, so that xor-ing hashes of similar entries
+// does not cancel out (the finalizer of MurmurHash3)
+inline size_t mix_hash(size_t h) {
+  uint64_t k = h;
+  k ^= k >> 33;
+  k *= 0xff51afd7ed558ccdULL;
+  k ^= k >> 33;
+  k *= 0xc4ceb9fe1a85ec53ULL;
+  k ^= k >> 33;
+  return (size_t) k;
+}
+
+template <class Key, class Value> struct DefaultEntry_hash {
+  size_t operator()(const Key& key, const Value& value) const {
+    size_t res = std::hash<Key>()(key);
+    res ^= std::hash<Value>()(value) + 0x9e3779b9 + (res<<6) + (res>>2); // see hash_combine
+    return mix_hash(res);
+  }
+};
+
+template <class Container> class SharedContainerTy {
+
+  protected:
+    std::shared_ptr<Container> c; // NULL means empty
+    mutable size_t hashcode;
+    mutable bool hashValid;
+
+    static const Container& emptyContainer() {
+      static const Container empty;
+      return empty;
+    }
+
+    Container& unshare() {
+      if (!c) {
+        c = std::make_shared<Container>();
+      } else if (c.use_count() > 1) {
+        c = std::make_shared<Container>(*c);
+      }
+      return *c;
+    }
+
+  public:
+    typedef typename Container::value_type value_type;
+    typedef typename Container::size_type size_type;
+    typedef typename Container::const_iterator const_iterator;
+    typedef const_iterator iterator;
+
+    SharedContainerTy(): c(), hashcode(0), hashValid(true) {}
+
+    const Container& get() const { return c ? *c : emptyContainer(); }
+
+    Container& modify() {
+      hashValid = false;
+      return unshare();
+    }
+
+    const_iterator begin() const { return get().begin(); }
+    const_iterator end() const { return get().end(); }
+    size_type size() const { return c ? c->size() : 0; }
+    bool empty() const { return !c || c->empty(); }
+    void clear() { c.reset(); hashcode = 0; hashValid = true; }
+};
+
+template <class Key, class Value, class EntryHash = DefaultEntry_hash<Key,Value>> class SharedMapTy : public SharedContainerTy<std::map<Key,Value>> {
+
+  public:
+    typedef std::map<Key,Value> MapTy;
+    typedef Key key_type;
+    typedef Value mapped_type;
+    typedef typename MapTy::const_iterator const_iterator;
+    typedef const_iterator iterator;
+    typedef typename MapTy::size_type size_type;
+
+    struct EntryRefTy { // so that map[key] = value keeps the hash
+      SharedMapTy& map;
+      const Key& key;
+      EntryRefTy& operator=(const Value& value) { map.set(key, value); return *this; }
+    };
+
+    const_iterator find(const Key& key) const { return this->get().find(key); }
+    size_type count(const Key& key) const { return this->get().count(key); }
+    const Value& at(const Key& key) const { return this->get().at(key); }
+
+    void set(const Key& key, const Value& value) {
+      MapTy& m = this->unshare();
+      auto msearch = m.find(key);
+      if (msearch == m.end()) {
+        msearch = m.insert({key, value}).first;
+      } else {
+        this->hashcode ^= EntryHash()(key, msearch->second);
+        msearch->second = value;
+      }
+      this->hashcode ^= EntryHash()(key, msearch->second);
+    }
+
+    EntryRefTy operator[](const Key& key) { return EntryRefTy{*this, key}; }
+
+    std::pair<const_iterator,bool> insert(const typename MapTy::value_type& v) {
+      auto minsert = this->unshare().insert(v);
+      if (minsert.second) {
+        this->hashcode ^= EntryHash()(v.first, v.second);
+      }
+      return minsert;
+    }
+
+    size_type erase(const Key& key) {
+      auto msearch = this->get().find(key);
+      if (msearch == this->get().end()) {
+        return 0; // avoid copying
+      }
+      erase(msearch);
+      return 1;
+    }
+
+    const_iterator erase(const_iterator pos) { // returns an iterator to the (possibly new) container
+      this->hashcode ^= EntryHash()(pos->first, pos->second);
+      if (this->c.use_count() > 1) {
+        Key key = pos->first;
+        MapTy& m = this->unshare();
+        return m.erase(m.find(key));
+      }
+      return this->c->erase(pos);
+    }
+
+    size_t hash() const {
+      if (!this->hashValid) {
+        size_t res = 0;
+        for(const_iterator mi = this->begin(), me = this->end(); mi != me; ++mi) {
+          res ^= EntryHash()(mi->first, mi->second);
+        }
+        this->hashcode = res;
+        this->hashValid = true;
+      }
+      return this->hashcode;
+    }
+
+    bool operator==(const SharedMapTy& other) const {
+      return this->c == other.c || (hash() == other.hash() && this->get() == other.get());
+    }
+    bool operator!=(const SharedMapTy& other) const { return !(*this == other); }
+};
+
+template <class T> class SharedVectorTy : public SharedContainerTy<std::vector<T>> {
+
+  typedef DefaultEntry_hash<size_t,T> EntryHash; // elements are hashed with their positions
+
+  public:
+    typedef std::vector<T> VectorTy;
+    typedef typename VectorTy::size_type size_type;
+
+    const T& at(size_type i) const { return this->get().at(i); }
+    const T& operator[](size_type i) const { return this->get()[i]; }
+    const T& back() const { return this->get().back(); }
+
+    void push_back(const T& v) {
+      this->hashcode ^= EntryHash()(this->size(), v);
+      this->unshare().push_back(v);
+    }
+
+    void pop_back() {
+      VectorTy& vec = this->unshare();
+      this->hashcode ^= EntryHash()(vec.size() - 1, vec.back());
+      vec.pop_back();
+    }
+
+    size_t hash() const {
+      if (!this->hashValid) {
+        size_t res = 0;
+        const VectorTy& vec = this->get();
+        for(size_type i = 0; i < vec.size(); i++) {
+          res ^= EntryHash()(i, vec[i]);
+        }
+        this->hashcode = res;
+        this->hashValid = true;
+      }
+      return this->hashcode;
+    }
+
+    bool operator==(const SharedVectorTy& other) const {
+      return this->c == other.c || (hash() == other.hash() && this->get() == other.get());
+    }
+    bool operator!=(const SharedVectorTy& other) const { return !(*this == other); }
+};
+
+#endif
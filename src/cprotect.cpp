@@ -2,7 +2,10 @@
 #include "cprotect.h"
 #include "table.h"
 #include "allocators.h"
+#include "cache.h"
+#include "lazy.h"
 
+#include <algorithm>
 #include <unordered_map>
 #include <vector>
 
@@ -52,6 +55,10 @@ struct CProtectFunctionState {
   ArgIndexTy argIndex;		// argument numbering
   bool confused;
   
+  // state of a function that will not be analyzed (loaded from the analyses cache)
+  CProtectFunctionState(Function *fun, ArgsTy exposed, ArgsTy usedAfterExposure, bool confused):
+    fun(fun), exposed(exposed), usedAfterExposure(usedAfterExposure), dirty(false), varIndex(), argIndex(), confused(confused) {};
+
   CProtectFunctionState(Function *fun): fun(fun), exposed(fun->arg_size(), false), usedAfterExposure(fun->arg_size(), false), dirty(false), varIndex(), argIndex(), confused(false) {
 
     // index variables
@@ -603,14 +610,104 @@ static void analyzeFunction(CProtectFunctionState& fstate, FunctionTableTy& func
   }
 }
 
+// the result depends on the allocating functions, so they are part of the name of the cached section
+
+static std::string cacheSection(FunctionsSetTy& allocatingFunctions) {
+
+  std::vector<std::string> names;
+  for(FunctionsSetTy::iterator fi = allocatingFunctions.begin(), fe = allocatingFunctions.end(); fi != fe; ++fi) {
+    Function *f = *fi;
+    if (analysesCache.isBaseFunction(f)) {
+      names.push_back(f->getName().str());
+    }
+  }
+  std::sort(names.begin(), names.end());
+  
+  std::string all;
+  for(std::vector<std::string>::iterator ni = names.begin(), ne = names.end(); ni != ne; ++ni) {
+    all += *ni;
+    all += ' ';
+  }
+  return "calleeProtect:" + std::to_string(std::hash<std::string>()(all));
+}
+
+// per base function: name, confused flag, and per argument 2*exposed + usedAfterExposure
+
+static void putToCache(Module *m, const std::string& section, FunctionTableTy& functions) {
+
+  std::vector<std::string> names;
+  for(FunctionTableTy::iterator fi = functions.begin(), fe = functions.end(); fi != fe; ++fi) {
+    if (analysesCache.isBaseFunction(fi->first)) {
+      names.push_back(fi->first->getName().str());
+    }
+  }
+  std::sort(names.begin(), names.end());
+  
+  CacheWriterTy writer;
+  for(std::vector<std::string>::iterator ni = names.begin(), ne = names.end(); ni != ne; ++ni) {
+    CProtectFunctionState& fstate = getFunctionState(functions, m->getFunction(*ni));
+    writer.put(fstate.fun);
+    writer.put(fstate.confused);
+    std::string args;
+    unsigned nargs = fstate.exposed.size();
+    for(unsigned i = 0; i < nargs; i++) {
+      args += (char) ('0' + 2 * fstate.exposed.at(i) + fstate.usedAfterExposure.at(i));
+    }
+    writer.put(args);
+  }
+  analysesCache.put(m, section, writer.str());
+}
+
+static bool getFromCache(Module *m, const std::string& section, FunctionTableTy& functions) {
+
+  std::string payload;
+  if (!analysesCache.get(m, section, payload)) {
+    return false;
+  }
+  CacheReaderTy reader(payload, m);
+  FunctionTableTy cached;
+  while(!reader.atEnd()) {
+    Function *f;
+    unsigned long confused;
+    std::string args;
+    if (!reader.get(f) || !reader.get(confused) || !reader.get(args) || args.size() != f->arg_size()) {
+      return false;
+    }
+    unsigned nargs = args.size();
+    ArgsTy exposed(nargs, false);
+    ArgsTy usedAfterExposure(nargs, false);
+    for(unsigned i = 0; i < nargs; i++) {
+      unsigned bits = args[i] - '0';
+      exposed.at(i) = bits & 2;
+      usedAfterExposure.at(i) = bits & 1;
+    }
+    cached.insert({f, CProtectFunctionState(f, exposed, usedAfterExposure, confused)});
+  }
+  functions.swap(cached);
+  return true;
+}
+
 CProtectInfo findCalleeProtectFunctions(Module *m, FunctionsSetTy& allocatingFunctions) {
 
   FunctionTableTy functions; // function envelopes
   FunctionListTy workList; // functions to be re-analyzed
   
+  std::string section;
+  bool cached = false;
+  if (analysesCache.enabled(m)) {
+    section = cacheSection(allocatingFunctions);
+    cached = getFromCache(m, section, functions); // base functions will not be re-analyzed
+  }
+  if (!cached) {
+    materializeModule(m);
+  }
+  
   if (DEBUG) errs() << "adding functions..\n";
   for(Module::iterator fi = m->begin(), fe = m->end(); fi != fe; ++fi) {
     Function *f = &*fi;
+    if (cached && analysesCache.isBaseFunction(f)) {
+      continue;
+    }
     CProtectFunctionState fstate(f);
     auto finsert = functions.insert({f, fstate});
     myassert(finsert.second);
@@ -628,6 +725,9 @@ CProtectInfo findCalleeProtectFunctions(Module *m, FunctionsSetTy& allocatingFun
       //   but then it does not have to be re-analyzed just because of 
       //   that it has been re-analyzed
   }  
+  if (analysesCache.enabled(m) && !cached) {
+    putToCache(m, section, functions);
+  }
   
   CProtectInfo cprotect;
   for(FunctionTableTy::iterator fi = functions.begin(), fe = functions.end(); fi != fe; ++fi) {
@@ -22,17 +22,13 @@
 
 #include "callocators.h"
 #include "lannotate.h"
+#include "tools.h"
 
 using namespace llvm;
 
-int main(int argc, char* argv[])
+static int runCsfpcheck(ModuleAnalysesTy& analyses, FunctionsOrderedSetTy& functionsOfInterestSet, FunctionsVectorTy& functionsOfInterestVector)
 {
-  LLVMContext context;
-
-  FunctionsOrderedSetTy functionsOfInterestSet;
-  FunctionsVectorTy functionsOfInterestVector;
-  Module *m = parseArgsReadIR(argc, argv, functionsOfInterestSet, functionsOfInterestVector, context);
-  CalledModuleTy *cm = CalledModuleTy::create(m);
+  CalledModuleTy *cm = analyses.getCalledModule();
 
   const CallSiteTargetsTy *callSiteTargets = cm->getCallSiteTargets();
   const CalledFunctionsSetTy *allocatingCFunctions = cm->getAllocatingCFunctions();
@@ -57,8 +53,15 @@ int main(int argc, char* argv[])
   }
 
   printLineAnnotations(sfpLines);
-  
-  CalledModuleTy::release(cm);  
-  delete m;
-}  
+  return 0;
+}
+
+const ToolTy csfpcheckTool = {"csfpcheck", NULL, runCsfpcheck, false, false};
+
+#ifndef RCHK_DRIVER
+int main(int argc, char* argv[])
+{
+  return runTool(csfpcheckTool, argc, argv);
+}
+#endif
 
@@ -16,18 +16,13 @@
 #include <llvm/Support/raw_ostream.h>
 
 #include "errors.h"
+#include "tools.h"
 
 using namespace llvm;
 
-int main(int argc, char* argv[])
+static int runErrcheck(ModuleAnalysesTy& analyses, FunctionsOrderedSetTy& functionsOfInterestSet, FunctionsVectorTy& functionsOfInterestVector)
 {
-  LLVMContext context;
-  FunctionsOrderedSetTy functionsOfInterestSet;
-  FunctionsVectorTy functionsOfInterestVector;  
-  
-  Module *m = parseArgsReadIR(argc, argv, functionsOfInterestSet, functionsOfInterestVector, context);
-  FunctionsSetTy errorFunctions;
-  findErrorFunctions(m, errorFunctions);
+  FunctionsSetTy& errorFunctions = *analyses.getErrorFunctions();
   
   for(FunctionsVectorTy::iterator fi = functionsOfInterestVector.begin(), fe = functionsOfInterestVector.end(); fi != fe; ++fi) {
     Function *fun = *fi;
@@ -51,5 +46,14 @@ int main(int argc, char* argv[])
       }
     }
   }
-  delete m;
-} 
+  return 0;
+}
+
+const ToolTy errcheckTool = {"errcheck", NULL, runErrcheck, false, true};
+
+#ifndef RCHK_DRIVER
+int main(int argc, char* argv[])
+{
+  return runTool(errcheckTool, argc, argv);
+}
+#endif
@@ -1,5 +1,7 @@
 
 #include "errors.h"
+#include "cache.h"
+#include "lazy.h"
 
 #include <llvm/IR/CallSite.h>
 #include <llvm/IR/Instructions.h>
@@ -105,11 +107,26 @@ void findErrorBasicBlocks(Function *fun, FunctionsSetTy *knownErrorFunctions, Ba
 
 void findErrorFunctions(Module *m, FunctionsSetTy& errorFunctions) {
 
+  FunctionsVectorTy candidates;
+  bool cached = analysesCache.getFunctions(m, "errorFunctions", errorFunctions);
+  if (cached) {
+    // only functions of a linked package remain to be analyzed (see cache.h)
+    if (!analysesCache.isLinked()) {
+      return;
+    }
+    analysesCache.getPackageFunctions(candidates);
+  } else {
+    materializeModule(m);
+    for(Module::iterator FI = m->begin(), FE = m->end(); FI != FE; ++FI) {
+      candidates.push_back(&*FI);
+    }
+  }
+
   bool addedErrorFunction = true;
   while(addedErrorFunction) {
     addedErrorFunction = false;
-    for(Module::iterator FI = m->begin(), FE = m->end(); FI != FE; ++FI) {
-      Function *fun = &*FI;
+    for(FunctionsVectorTy::iterator FI = candidates.begin(), FE = candidates.end(); FI != FE; ++FI) {
+      Function *fun = *FI;
 
       if (!fun) continue;
       if (!fun->size()) continue;
@@ -120,4 +137,7 @@ void findErrorFunctions(Module *m, FunctionsSetTy& errorFunctions) {
       }
     }
   }
+  if (!cached) {
+    analysesCache.putFunctions(m, "errorFunctions", errorFunctions);
+  }
 }
@@ -19,6 +19,7 @@
 #include <unordered_set>
 
 #include "symbols.h"
+#include "tools.h"
 
 #include <stdio.h>
 #include <string.h>
@@ -176,12 +177,11 @@ bool checkTable(Value *v, bool checkDotCallArity, StringMapTy& smap) {
   return true; /* successful parsing */
 }
 
-int main(int argc, char* argv[])
-{
-  LLVMContext context;
-  FunctionsOrderedSetTy functionsOfInterestSet;
-  FunctionsVectorTy functionsOfInterestVector;
+static bool readFunList = false;
+static char pkgname[PATH_MAX];
 
+static bool extractFficheckOptions(int& argc, char* argv[])
+{
   /* fficheck [-i] base.bc packagelib.bc */
   
   // most likely the base.bc is not really needed, at least for now
@@ -195,28 +195,26 @@ int main(int argc, char* argv[])
 
   if (argc < 2) {
     errs() << "fficheck [-i] R.bc pkg.so.bc\n";
-    return 2;
+    return false;
+  }
+  
+  for(int i = 1; i < argc; i++) {
+    if (!strncmp(argv[i], "--batch", 7) || !strncmp(argv[i], "--server", 8)) {
+      errs() << "fficheck does not support --batch and --server (the library name is taken from the module file name)\n";
+      return false;
+    }
   }
 
-  bool readFunList = false;
   if (!strcmp(argv[1], "-i")) {
     readFunList = true;
-    char **argvc = (char **) malloc(argc * sizeof(char *));
-    if (!argvc) {
-      errs() << "Out of memory.\n";
-      return 1;
+    for(int j = 1; j < argc; j++) { // including the terminating NULL
+      argv[j] = argv[j + 1];
     }
-    argvc[0] = argv[0];
-    int j = 1;
-    for(int i = 2; i < argc; i++)
-      argvc[j++] = argv[i];
-    argvc[j++] = NULL;
     argc--;
-    argv = argvc;
 
     if (argc < 2) {
       errs() << "fficheck [-i] R.bc pkg.so.bc\n";
-      return 2;
+      return false;
     }
   }
   
@@ -229,7 +227,6 @@ int main(int argc, char* argv[])
   if (sep != -1)
     s += sep + 1;
     
-  char pkgname[PATH_MAX];
   pkgname[0] = 0;
   for(i = 0; s[i] != 0; i++) {
     if (!strcmp(s + i, ".so") || !strcmp(s + i, ".bc") || !strcmp(s + i, ".so.bc")) {    
@@ -238,7 +235,13 @@ int main(int argc, char* argv[])
     pkgname[i] = s[i];
   }
   pkgname[i] = 0;
-  
+  return true;
+}
+
+static int runFficheck(ModuleAnalysesTy& analyses, FunctionsOrderedSetTy& functionsOfInterestSet, FunctionsVectorTy& functionsOfInterestVector)
+{
+  Module *m = analyses.getModule();
+
   if (pkgname[0] == 0) {
     errs() << "ERROR: cannot detect package name\n";
   }
@@ -247,8 +250,6 @@ int main(int argc, char* argv[])
      This is often a package name, but not always, but it is always the name that
      defines the suffix in R_init_suffix and it is used here only for that purpose.
   */
-  
-  Module *m = parseArgsReadIR(argc, argv, functionsOfInterestSet, functionsOfInterestVector, context);
  
   std::string initfn = "R_init_";
   initfn.append(pkgname);
@@ -348,10 +349,15 @@ int main(int argc, char* argv[])
         break;
     }
     errs() << "Checked additional specified functions: " << checked << "\n";
-    free(argv);
   }
-  
-  
-  delete m;
   return 0;
 }
+
+const ToolTy fficheckTool = {"fficheck", extractFficheckOptions, runFficheck, false, false};
+
+#ifndef RCHK_DRIVER
+int main(int argc, char* argv[])
+{
+  return runTool(fficheckTool, argc, argv);
+}
+#endif
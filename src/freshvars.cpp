@@ -25,7 +25,7 @@ static void pruneFreshVars(Instruction *in, FreshVarsTy& freshVars, LiveVarsTy&
   //   remove entries and conditional messages for dead variables
   //   also print conditional messages for variables that are now definitely going to be used
     
-  for (FreshVarsVarsTy::iterator fi = freshVars.vars.begin(), fe = freshVars.vars.end(); fi != fe;) {
+  for (FreshVarsVarsTy::iterator fi = freshVars.vars.begin(); fi != freshVars.vars.end();) { // erase may unshare the map
     AllocaInst *var = fi->first;
       
     auto lsearch = liveVars.find(in);
@@ -40,7 +40,8 @@ static void pruneFreshVars(Instruction *in, FreshVarsTy& freshVars, LiveVarsTy&
     } else if (!lvars.isPossiblyKilled(var)) {
       auto msearch = freshVars.condMsgs.find(var);
       if (msearch != freshVars.condMsgs.end()) {
-        msearch->second.flush();
+        DelayedLineMessenger dmsg = msearch->second; // the messages may be shared with other states
+        dmsg.flush();
         refinableInfos++;
         freshVars.condMsgs.erase(msearch);
         if (msg.debug()) msg.debug(MSG_PFX + "printed conditional messages as variable " + varName(var) + " is now definitely going to be used", in);
@@ -52,7 +53,8 @@ static void pruneFreshVars(Instruction *in, FreshVarsTy& freshVars, LiveVarsTy&
 
 static void unprotectAll(FreshVarsTy& freshVars) {
   freshVars.pstack.clear();
-  for (FreshVarsVarsTy::iterator fi = freshVars.vars.begin(), fe = freshVars.vars.end(); fi != fe; ++fi) {
+  FreshVarsVarsTy::MapTy& vars = freshVars.vars.modify();
+  for (FreshVarsVarsTy::MapTy::iterator fi = vars.begin(), fe = vars.end(); fi != fe; ++fi) {
     fi->second = 0; // zero protect count
   }
 }
@@ -80,7 +82,7 @@ static void issueConditionalMessage(Instruction *in, AllocaInst *var, FreshVarsT
     freshVars.condMsgs.insert({var, dmsg});
     if (msg.debug()) msg.debug(MSG_PFX + "created conditional message \"" + message + "\" first for variable " + varName(var), in);
   } else {
-    DelayedLineMessenger& dmsg = vsearch->second;
+    DelayedLineMessenger& dmsg = freshVars.condMsgs.modify().at(var);
     dmsg.info(MSG_PFX + message, in);
     if (msg.debug()) msg.debug(MSG_PFX + "added conditional message \"" + message + "\" for variable " + varName(var) + "(size " + std::to_string(dmsg.size()) + ")", in);
   }
@@ -155,7 +157,7 @@ static void unprotectOne(FreshVarsTy& freshVars, LineMessenger& msg, unsigned& r
     } else {
       if (msg.debug()) msg.debug(MSG_PFX + "decremented protect count of variable " + varName(var) + " to " + std::to_string(nProtects), in);
     }
-    vsearch->second = nProtects;
+    freshVars.vars[var] = nProtects;
   }
   if (msg.debug()) msg.debug(MSG_PFX + "unprotected variable " + varName(var), in);
 }
@@ -315,7 +317,7 @@ static void handleCall(Instruction *in, CalledModuleTy *cm, SEXPGuardsChecker *s
             // typically it was before protected just once, so lets set its protect count to 1
           
             nProtects = 1;
-            vsearch->second = nProtects;
+            freshVars.vars[var] = nProtects;
             if (msg.debug()) msg.debug(MSG_PFX + "set protect count of variable " + varName(var) + " to 1 at REPROTECT (heuristic)", in);
           }	
         } else {
@@ -350,7 +352,7 @@ static void handleCall(Instruction *in, CalledModuleTy *cm, SEXPGuardsChecker *s
         auto vsearch = freshVars.vars.find(var);
         if (vsearch != freshVars.vars.end()) {
           int nProtects = vsearch->second;
-          vsearch->second = ++nProtects;
+          freshVars.vars[var] = ++nProtects;
           if (msg.debug()) msg.debug(MSG_PFX + "incremented protect count of variable " + varName(var) + " to " + std::to_string(nProtects), in); 
         } else {
           // the variable is not currently fresh, but the fact that it is being protected actually means
@@ -525,7 +527,8 @@ static void handleLoad(Instruction *in, CalledModuleTy *cm, SEXPGuardsChecker* s
   // check for conditional messages
   auto msearch = freshVars.condMsgs.find(var);
   if (msearch != freshVars.condMsgs.end()) {
-    msearch->second.flush();
+    DelayedLineMessenger dmsg = msearch->second; // the messages may be shared with other states
+    dmsg.flush();
     refinableInfos++;
     freshVars.condMsgs.erase(msearch);
     if (msg.debug()) msg.debug(MSG_PFX + "printed conditional messages on use of variable " + varName(var), in);
@@ -797,7 +800,7 @@ static void handleStore(Instruction *in, CalledModuleTy *cm, SEXPGuardsChecker *
         freshVars.vars.insert({var, nProtects});
         // remember, insert won't overwrite std::map value for an existing key
       } else {
-        vsearch->second = nProtects;
+        freshVars.vars[var] = nProtects;
       }
       if (msg.debug()) msg.debug(MSG_PFX + "initialized fresh SEXP variable " + varName(var) + " with protect count " + std::to_string(nProtects) +
         " allocated by " + funName(srcFun), in);
@@ -821,7 +824,7 @@ static void handleStore(Instruction *in, CalledModuleTy *cm, SEXPGuardsChecker *
                   freshVars.vars.insert({var, nProtects});
                   // remember, insert won't overwrite std::map value for an existing key
                 } else {
-                  vsearch->second = nProtects;
+                  freshVars.vars[var] = nProtects;
                 }
                 if (msg.debug()) msg.debug(MSG_PFX + "initialized fresh SEXP variable " + varName(var) + " with protect count " + std::to_string(nProtects) +
                   " based on derived assignment from fresh variable " + varName(dvars), in);
@@ -868,7 +871,7 @@ void StateWithFreshVarsTy::dump(bool verbose) {
     auto vsearch = freshVars.condMsgs.find(var);
     if (vsearch != freshVars.condMsgs.end()) {
       errs() << " conditional messages: \n";
-      DelayedLineMessenger& dmsg = vsearch->second;
+      const DelayedLineMessenger& dmsg = vsearch->second;
       dmsg.print("    ");
     }
     
@@ -3,6 +3,7 @@
 
 #include "common.h"
 
+#include "cow.h"
 #include "linemsg.h"
 #include "state.h"
 #include "guards.h"
@@ -19,9 +20,20 @@ using namespace llvm;
 
 const int MAX_PSTACK_SIZE = 64;
 
-typedef std::map<AllocaInst*, int> FreshVarsVarsTy;
-typedef std::map<AllocaInst*, DelayedLineMessenger> ConditionalMessagesTy;
-typedef std::vector<AllocaInst*> VarsVectorTy;
+struct ConditionalMessagesEntry_hash {
+  size_t operator()(AllocaInst* var, const DelayedLineMessenger& msg) const {
+    size_t res = 0;
+    hash_combine(res, (void *) var);
+    for(LineInfoPtrSetTy::const_iterator li = msg.delayedLineBuffer.begin(), le = msg.delayedLineBuffer.end(); li != le; ++li) {
+      hash_combine(res, (const void *) *li); // interned
+    }
+    return mix_hash(res);
+  }
+};
+
+typedef SharedMapTy<AllocaInst*, int> FreshVarsVarsTy;
+typedef SharedMapTy<AllocaInst*, DelayedLineMessenger, ConditionalMessagesEntry_hash> ConditionalMessagesTy;
+typedef SharedVectorTy<AllocaInst*> VarsVectorTy;
 
 struct FreshVarsTy {
   FreshVarsVarsTy vars;
@@ -48,12 +60,16 @@ struct FreshVarsTy {
     // true when the tool is confused by the code and the results
     // from now on are only very very approximative
     //   (e.g. when there is an UNPROTECT(nprotect)
+
+  bool operator==(const FreshVarsTy& other) const {
+    return vars == other.vars && pstack == other.pstack && condMsgs == other.condMsgs && confused == other.confused;
+  }
 };
 
 struct StateWithFreshVarsTy : virtual public StateBaseTy {
   FreshVarsTy freshVars;
   
-  StateWithFreshVarsTy(BasicBlock *bb, FreshVarsTy& freshVars): StateBaseTy(bb), freshVars(freshVars) {};
+  StateWithFreshVarsTy(BasicBlock *bb, const FreshVarsTy& freshVars): StateBaseTy(bb), freshVars(freshVars) {};
   StateWithFreshVarsTy(BasicBlock *bb): StateBaseTy(bb), freshVars() {};
   
   virtual StateWithFreshVarsTy* clone(BasicBlock *newBB) = 0;
@@ -18,6 +18,7 @@
 #include <unordered_set>
 
 #include "symbols.h"
+#include "tools.h"
 
 using namespace llvm;
 
@@ -57,17 +58,12 @@ bool isStructureWithSEXPFields(Type *t) {
   return containsSEXP(t, visited);
 }
 
-int main(int argc, char* argv[])
+static int runGlcheck(ModuleAnalysesTy& analyses, FunctionsOrderedSetTy& functionsOfInterestSet, FunctionsVectorTy& functionsOfInterestVector)
 {
-  LLVMContext context;
-  FunctionsOrderedSetTy functionsOfInterestSet;
-  FunctionsVectorTy functionsOfInterestVector;
-  
-  Module *m = parseArgsReadIR(argc, argv, functionsOfInterestSet, functionsOfInterestVector, context);
     // NOTE: functionsOfInterest ignored but (re-)analyzing the R core is necessary
   
-  SymbolsMapTy symbolsMap;
-  findSymbols(m, &symbolsMap); // symbols are globals which hold SEXPs, but are safe
+  Module *m = analyses.getModule();
+  SymbolsMapTy& symbolsMap = *analyses.getSymbolsMap(); // symbols are globals which hold SEXPs, but are safe
   
   for(Module::global_iterator gi = m->global_begin(), ge = m->global_end(); gi != ge ; ++gi) {
     GlobalVariable *gv = &*gi;
@@ -86,6 +82,14 @@ int main(int argc, char* argv[])
       errs() << "structure with SEXP fields " << gv->getName() << " " << *gv << "\n";
     }
   }
-  
-  delete m;
+  return 0;
+}
+
+const ToolTy glcheckTool = {"glcheck", NULL, runGlcheck, false, false};
+
+#ifndef RCHK_DRIVER
+int main(int argc, char* argv[])
+{
+  return runTool(glcheckTool, argc, argv);
 }
+#endif
@@ -45,11 +45,10 @@ static bool isIntegerGuardVariable(AllocaInst* var) {
         if (!ci->isEquality()) {
           continue;
         }
-        if (Constant::classof(ci->getOperand(0))) {
-          ci->swapOperands();
-        }
-        if (ConstantInt::classof(ci->getOperand(1))) {
-          ConstantInt *constOp = cast<ConstantInt>(ci->getOperand(1));
+        Value *op = Constant::classof(ci->getOperand(0)) ? ci->getOperand(0) : ci->getOperand(1);
+          // not swapping the operands, the IR has to stay read-only (functions may be checked in parallel)
+        if (ConstantInt::classof(op)) {
+          ConstantInt *constOp = cast<ConstantInt>(op);
           if (constOp->isZero()) {
             nComparisons++;
           } else {
@@ -243,6 +242,21 @@ bool IntGuardsChecker::handleForTerminator(TerminatorInst* t, StateWithGuardsTy&
   return true;
 }
 
+static void indexAllVariables(Function *f, IndexedTable<AllocaInst>& varIndex) {
+
+  for(Function::iterator bi = f->begin(), be = f->end(); bi != be; ++bi) {
+    for(BasicBlock::iterator ii = bi->begin(), ie = bi->end(); ii != ie; ++ii) {
+      if (AllocaInst *var = dyn_cast<AllocaInst>(&*ii)) {
+        varIndex.indexOf(var);
+      }
+    }
+  }
+}
+
+void IntGuardsChecker::indexVariables(Function *f) {
+  indexAllVariables(f, varIndex);
+}
+
 PackedIntGuardsTy IntGuardsChecker::pack(const IntGuardsTy& intGuards) {
 
   // note we first have to call indexOf on each variable to make sure
@@ -253,7 +267,21 @@ PackedIntGuardsTy IntGuardsChecker::pack(const IntGuardsTy& intGuards) {
     varIndex.indexOf(var);
   }  
 
-  PackedIntGuardsTy packed(varIndex.size());
+  // only include variables up to the last one with a known state, so that the
+  // packed form does not depend on how many variables have been indexed so far
+  // (and equal guards always pack to equal bits)
+  
+  unsigned nvars = 0;
+  for(IntGuardsTy::const_iterator gi = intGuards.begin(), ge = intGuards.end(); gi != ge; ++gi) {
+    if (gi->second != IGS_UNKNOWN) {
+      unsigned varIdx = varIndex.indexOf(gi->first);
+      if (varIdx >= nvars) {
+        nvars = varIdx + 1;
+      }
+    }
+  }
+
+  PackedIntGuardsTy packed(nvars);
   
   for(IntGuardsTy::const_iterator gi = intGuards.begin(), ge = intGuards.end(); gi != ge; ++gi) {
     AllocaInst* var = gi->first;
@@ -262,6 +290,9 @@ PackedIntGuardsTy IntGuardsChecker::pack(const IntGuardsTy& intGuards) {
     unsigned varIdx = varIndex.indexOf(var);
     unsigned base = varIdx * IGS_BITS;
     
+    if (gs == IGS_UNKNOWN) {
+      continue; // may be beyond the packed variables
+    }
     switch(gs) {
       case IGS_NONZERO: packed.bits[base] = true; break;     // 1 0
       case IGS_ZERO:    packed.bits[base + 1] = true; break; // 0 1
@@ -298,14 +329,7 @@ IntGuardsTy IntGuardsChecker::unpack(const PackedIntGuardsTy& intGuards) {
 }
   
 void IntGuardsChecker::hash(size_t& res, const IntGuardsTy& intGuards) {
-
-  hash_combine(res, intGuards.size());
-  for(IntGuardsTy::const_iterator gi = intGuards.begin(), ge = intGuards.end(); gi != ge; ++gi) {
-    AllocaInst* var = gi->first;
-    IntGuardState s = gi->second;
-    hash_combine(res, (void *)var);
-    hash_combine(res, (size_t) s);
-  } // ordered map
+  hash_combine(res, intGuards.hash()); // maintained incrementally
 }
 
 // SEXP guard is a local variable of type SEXP
@@ -418,7 +442,7 @@ bool SEXPGuardsChecker::isGuard(AllocaInst* var) {
   return res;
 }
 
-std::string sgs_name(SEXPGuardTy& g) {
+std::string sgs_name(const SEXPGuardTy& g) {
 
   SEXPGuardState sgs = g.state;
   switch(sgs) {
@@ -1045,6 +1069,10 @@ bool SEXPGuardsChecker::handleForTerminator(TerminatorInst* t, StateWithGuardsTy
   return true;  
 }
   
+void SEXPGuardsChecker::indexVariables(Function *f) {
+  indexAllVariables(f, varIndex);
+}
+
 PackedSEXPGuardsTy SEXPGuardsChecker::pack(const SEXPGuardsTy& sexpGuards) {
 
   // note we first have to call indexOf on each variable to make sure
@@ -1055,14 +1083,26 @@ PackedSEXPGuardsTy SEXPGuardsChecker::pack(const SEXPGuardsTy& sexpGuards) {
     varIndex.indexOf(var);
   }  
   
-  PackedSEXPGuardsTy packed(varIndex.size());
+  // only include variables up to the last one with a known state (see IntGuardsChecker::pack)
+
+  unsigned nvars = 0;
+  for(SEXPGuardsTy::const_iterator gi = sexpGuards.begin(), ge = sexpGuards.end(); gi != ge; ++gi) {
+    if (gi->second.state != SGS_UNKNOWN) {
+      unsigned idx = varIndex.indexOf(gi->first);
+      if (idx >= nvars) {
+        nvars = idx + 1;
+      }
+    }
+  }
+  
+  PackedSEXPGuardsTy packed(nvars);
   
   const VarIndexTy::Index& vars = varIndex.getIndex();
   unsigned idx = 0;
   
   // store variables in the order of varIndex, so that symbol names in the list of symbols
   //   can be mapped back to variables
-  for(VarIndexTy::Index::const_iterator vi = vars.begin(), ve = vars.end(); vi != ve; ++vi, ++idx) {
+  for(VarIndexTy::Index::const_iterator vi = vars.begin(), ve = vars.end(); vi != ve && idx < nvars; ++vi, ++idx) {
     AllocaInst *var = *vi;
     
     auto vfind = sexpGuards.find(var);
@@ -1127,14 +1167,7 @@ SEXPGuardsTy SEXPGuardsChecker::unpack(const PackedSEXPGuardsTy& sexpGuards) {
 }
   
 void SEXPGuardsChecker::hash(size_t& res, const SEXPGuardsTy& sexpGuards) {
-  hash_combine(res, sexpGuards.size());
-  for(SEXPGuardsTy::const_iterator gi = sexpGuards.begin(), ge = sexpGuards.end(); gi != ge; ++gi) {
-    AllocaInst* var = gi->first;
-    const SEXPGuardTy& g = gi->second;
-    hash_combine(res, (void *) var);
-    hash_combine(res, (size_t) g.state);
-    hash_combine(res, g.symbolName);
-  } // ordered map
+  hash_combine(res, sexpGuards.hash()); // maintained incrementally
 }
 
 // common
@@ -1155,7 +1188,7 @@ void StateWithGuardsTy::dump(bool verbose) {
   errs() << "=== sexp guards: " << &sexpGuards << "\n";
   for(SEXPGuardsTy::iterator gi = sexpGuards.begin(), ge = sexpGuards.end(); gi != ge; ++gi) {
     AllocaInst *i = gi->first;
-    SEXPGuardTy &g = gi->second;
+    const SEXPGuardTy &g = gi->second;
     
     errs() << "   " << varName(i) << " ";
     if (verbose) {
@@ -6,10 +6,13 @@
 
 #include <llvm/IR/Instructions.h>
 
+#include "cow.h"
+
 using namespace llvm;
 
 struct SEXPGuardTy; // there is a cyclic dependency between guards.h and vectors.h
-typedef std::map<AllocaInst*,SEXPGuardTy> SEXPGuardsTy;
+struct SEXPGuardEntry_hash;
+typedef SharedMapTy<AllocaInst*,SEXPGuardTy,SEXPGuardEntry_hash> SEXPGuardsTy;
 class SEXPGuardsChecker;
 
 #include "common.h"
@@ -29,7 +32,19 @@ enum IntGuardState {
 };
 const unsigned IGS_BITS = 2;
 
-typedef std::map<AllocaInst*,IntGuardState> IntGuardsTy;
+struct IntGuardEntry_hash {
+  size_t operator()(AllocaInst* var, IntGuardState gs) const {
+    if (gs == IGS_UNKNOWN) {
+      return 0; // same as not having the entry
+    }
+    size_t res = 0;
+    hash_combine(res, (void *) var);
+    hash_combine(res, (char) gs);
+    return mix_hash(res);
+  }
+};
+
+typedef SharedMapTy<AllocaInst*,IntGuardState,IntGuardEntry_hash> IntGuardsTy;
 
 struct PackedIntGuardsTy {
 
@@ -40,6 +55,12 @@ struct PackedIntGuardsTy {
   bool operator==(const PackedIntGuardsTy& other) const { return bits == other.bits; };
 };
 
+struct PackedIntGuardsTy_hash {
+  size_t operator()(const PackedIntGuardsTy& t) const {
+    return std::hash<PackedIntGuardsTy::BitsTy>()(t.bits);
+  }
+};
+
 struct StateWithGuardsTy;
 
 std::string igs_name(IntGuardState igs);
@@ -56,6 +77,7 @@ class IntGuardsChecker {
   public:
     IntGuardsChecker(LineMessenger* msg): varIndex(), varsCache(), msg(msg) {};
 
+    void indexVariables(Function *f); // then packing does not modify the checker (see bcheck --function-jobs)
     PackedIntGuardsTy pack(const IntGuardsTy& intGuards);
     IntGuardsTy unpack(const PackedIntGuardsTy& intGuards);
     void hash(size_t& res, const IntGuardsTy& intGuards);
@@ -94,6 +116,21 @@ struct SEXPGuardTy {
   
 };
 
+struct SEXPGuardEntry_hash {
+  size_t operator()(AllocaInst* var, const SEXPGuardTy& g) const {
+    if (g.state == SGS_UNKNOWN) {
+      return 0; // same as not having the entry
+    }
+    size_t res = 0;
+    hash_combine(res, (void *) var);
+    hash_combine(res, (char) g.state);
+    if (g.state == SGS_SYMBOL) {
+      hash_combine(res, g.symbolName);
+    }
+    return mix_hash(res);
+  }
+};
+
 
 
 struct PackedSEXPGuardsTy {
@@ -108,6 +145,16 @@ struct PackedSEXPGuardsTy {
   bool operator==(const PackedSEXPGuardsTy& other) const { return bits == other.bits && symbols == other.symbols; };
 };
 
+struct PackedSEXPGuardsTy_hash {
+  size_t operator()(const PackedSEXPGuardsTy& t) const {
+    size_t res = std::hash<PackedSEXPGuardsTy::BitsTy>()(t.bits);
+    for(PackedSEXPGuardsTy::SymbolsTy::const_iterator si = t.symbols.begin(), se = t.symbols.end(); si != se; ++si) {
+      hash_combine(res, *si);
+    }
+    return res;
+  }
+};
+
   // yikes, need forward type-def
 struct ArgInfoTy;
 typedef std::vector<const ArgInfoTy*> ArgInfosVectorTy;
@@ -132,6 +179,7 @@ class SEXPGuardsChecker {
       VrfStateTy* vrfState, CalledModuleTy* cm):
       varIndex(), varsCache(), msg(msg), g(g), possibleAllocators(possibleAllocators), symbolsMap(symbolsMap), argInfos(argInfos), vrfState(vrfState), cm(cm) {};
 
+    void indexVariables(Function *f); // then packing does not modify the checker (see bcheck --function-jobs)
     PackedSEXPGuardsTy pack(const SEXPGuardsTy& sexpGuards);
     SEXPGuardsTy unpack(const PackedSEXPGuardsTy& sexpGuards);
     void hash(size_t& res, const SEXPGuardsTy& sexpGuards);
@@ -171,11 +219,14 @@ struct StateWithGuardsTy : virtual public StateBaseTy {
   void dump(bool verbose);
 };
 
+// the packed guards are interned by the tools, so that states share them and
+// they can be compared by pointers
+
 struct PackedStateWithGuardsTy : virtual public PackedStateBaseTy {
-  const PackedIntGuardsTy intGuards;
-  const PackedSEXPGuardsTy sexpGuards;
+  const PackedIntGuardsTy *intGuards; // interned
+  const PackedSEXPGuardsTy *sexpGuards; // interned
   
-  PackedStateWithGuardsTy(BasicBlock *bb, const PackedIntGuardsTy& intGuards, const PackedSEXPGuardsTy& sexpGuards):
+  PackedStateWithGuardsTy(BasicBlock *bb, const PackedIntGuardsTy *intGuards, const PackedSEXPGuardsTy *sexpGuards):
     PackedStateBaseTy(bb), intGuards(intGuards), sexpGuards(sexpGuards) {};
 };
 
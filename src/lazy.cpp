@@ -0,0 +1,117 @@
+
+#include "lazy.h"
+
+#include <unordered_set>
+#include <vector>
+
+#include <llvm/IR/Constants.h>
+#include <llvm/IR/Function.h>
+#include <llvm/IR/GlobalAlias.h>
+#include <llvm/IR/InstIterator.h>
+#include <llvm/IRReader/IRReader.h>
+#include <llvm/Support/Error.h>
+#include <llvm/Support/raw_ostream.h>
+
+using namespace llvm;
+
+bool lazyLoading = false;
+
+bool extractLazyOptions(int& argc, char* argv[]) {
+
+  lazyLoading = extractFlag(argc, argv, "lazy");
+  return true;
+}
+
+Module *readBaseModule(const std::string& fname, SMDiagnostic& error, LLVMContext& context) {
+
+  if (lazyLoading) {
+    return getLazyIRFileModule(fname, error, context).release();
+  }
+  return parseIRFile(fname, error, context).release();
+}
+
+// the bitcode file has already been parsed, so reading a body fails only
+// when the file is corrupt
+
+#if LLVM_VERSION_MAJOR>=4
+static void checkRead(Error err, const std::string& what) {
+  if (err) {
+    errs() << "ERROR: Cannot read " << what << ": " << toString(std::move(err)) << "\n";
+    exit(1);
+  }
+}
+#else
+static void checkRead(std::error_code err, const std::string& what) {
+  if (err) {
+    errs() << "ERROR: Cannot read " << what << ": " << err.message() << "\n";
+    exit(1);
+  }
+}
+#endif
+
+typedef std::unordered_set<const Constant*> ConstantsSetTy;
+
+static void addReferencedFunctions(Value *v, FunctionsVectorTy& workList, FunctionsSetTy& visited, ConstantsSetTy& visitedConstants) {
+
+  if (Function *f = dyn_cast<Function>(v)) {
+    if (visited.insert(f).second) {
+      workList.push_back(f);
+    }
+    return;
+  }
+  if (GlobalAlias *ga = dyn_cast<GlobalAlias>(v)) {
+    addReferencedFunctions(ga->getAliasee(), workList, visited, visitedConstants);
+    return;
+  }
+  if (GlobalValue::classof(v)) {
+    return; // initializers of global variables are not followed
+  }
+  Constant *c = dyn_cast<Constant>(v);
+  if (!c || !visitedConstants.insert(c).second) {
+    return;
+  }
+  for(User::op_iterator oi = c->op_begin(), oe = c->op_end(); oi != oe; ++oi) {
+    addReferencedFunctions(*oi, workList, visited, visitedConstants);
+  }
+}
+
+void materializeReachable(Module *m, const FunctionsOrderedSetTy& roots) {
+
+  if (!lazyLoading || !m->getMaterializer()) {
+    return;
+  }
+
+  FunctionsVectorTy workList;
+  FunctionsSetTy visited;
+  ConstantsSetTy visitedConstants;
+
+  for(FunctionsOrderedSetTy::const_iterator fi = roots.begin(), fe = roots.end(); fi != fe; ++fi) {
+    addReferencedFunctions(*fi, workList, visited, visitedConstants);
+  }
+
+  while(!workList.empty()) {
+    Function *f = workList.back();
+    workList.pop_back();
+
+    if (f->isMaterializable()) {
+      checkRead(f->materialize(), "function " + funName(f));
+    }
+    if (f->hasPersonalityFn()) {
+      addReferencedFunctions(f->getPersonalityFn(), workList, visited, visitedConstants);
+    }
+    for(inst_iterator ii = inst_begin(*f), ie = inst_end(*f); ii != ie; ++ii) {
+      Instruction *in = &*ii;
+      for(User::op_iterator oi = in->op_begin(), oe = in->op_end(); oi != oe; ++oi) {
+        addReferencedFunctions(*oi, workList, visited, visitedConstants);
+      }
+    }
+  }
+}
+
+void materializeModule(Module *m) {
+
+  if (!lazyLoading || !m->getMaterializer()) {
+    return;
+  }
+  checkRead(m->materializeAll(), "module " + m->getModuleIdentifier());
+}
@@ -0,0 +1,40 @@
+#ifndef RCHK_LAZY_H
+#define RCHK_LAZY_H
+
+#include "common.h"
+
+#include <string>
+
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/Module.h>
+#include <llvm/Support/SourceMgr.h>
+
+using namespace llvm;
+
+// lazy reading of the base module (R.bin.bc)
+//   it is enabled using command line option of all tools
+//     --lazy    read the bodies of base functions only when they are needed
+//
+//   when a package module is linked in, only the bodies of functions reachable
+//   from the package functions (referenced from their bodies, transitively) are
+//   read; the checks of package functions look at no other bodies
+//
+//   analyses of the whole module (error functions, allocators, callee-protect
+//   functions, symbols) read all the remaining bodies before they run, unless
+//   their results for the base module are in the analyses cache (see cache.h);
+//   so --lazy saves time and memory with a populated cache, e.g. with --cache-dir
+//   or in batch and server modes (see batch.h)
+//
+//   when the base module itself is checked, or when a tool reports on all
+//   functions of the module (veccheck, see ToolTy in analyses.h), all bodies
+//   are read right away
+
+extern bool lazyLoading;
+
+bool extractLazyOptions(int& argc, char* argv[]); // false on invalid options
+
+Module *readBaseModule(const std::string& fname, SMDiagnostic& error, LLVMContext& context); // NULL on error
+void materializeReachable(Module *m, const FunctionsOrderedSetTy& roots); // bodies of functions reachable from roots
+void materializeModule(Module *m); // all bodies not read yet
+
+#endif
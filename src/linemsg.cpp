@@ -48,15 +48,15 @@ void BaseLineMessenger::emit(const std::string& kind, const std::string& message
 
 // -----------------------------
 
-void LineInfoTy::print() const {
-  outs() << "  ";
+void LineInfoTy::print(raw_ostream& out) const {
+  out << "  ";
   if (!kind.empty()) {
-    outs()  << kind << ": ";
+    out  << kind << ": ";
   }
   if (path.empty()) {
-    outs() << message << "\n";
+    out << message << "\n";
   } else {
-    outs() << message << " " << path << ":" << line << "\n";
+    out << message << " " << path << ":" << line << "\n";
   }
 }
 
@@ -87,12 +87,14 @@ bool LineInfoTy_equal::operator() (const LineInfoTy& lhs, const LineInfoTy& rhs)
 
 // ----------------------------- 
 
+thread_local LineInfoPtrVectorTy* LineMessenger::recorder = NULL;
+
 void LineMessenger::flush() {
   if (lastFunction != NULL && !lineBuffer.empty()) {
-    outs() << "\nFunction " << funName(lastFunction) << lastChecksName << "\n";
+    *out << "\nFunction " << funName(lastFunction) << lastChecksName << "\n";
     for(LineInfoPtrSetTy::const_iterator liBuf = lineBuffer.begin(), liEbuf = lineBuffer.end(); liBuf != liEbuf; ++liBuf) {
       const LineInfoTy* li = *liBuf;
-      li->print();
+      li->print(*out);
     }
     lineBuffer.clear();
   }
@@ -102,7 +104,7 @@ void LineMessenger::flush() {
 
 void LineMessenger::newFunction(Function *func, const std::string& checksName) {
   if (!UNIQUE_MSG) {
-    outs() << "\nFunction " << funName(func) << checksName << "\n";
+    *out << "\nFunction " << funName(func) << checksName << "\n";
   } else {
     flush();
   }
@@ -111,8 +113,12 @@ void LineMessenger::newFunction(Function *func, const std::string& checksName) {
 }
 
 void LineMessenger::emitInterned(const LineInfoTy* li) {
+  if (recorder) {
+    recorder->push_back(li);
+  }
+  std::lock_guard<std::mutex> lock(mutex);
   if (!UNIQUE_MSG) {
-    li->print();
+    li->print(*out);
   } else {
     lineBuffer.insert(li);
   }
@@ -123,12 +129,13 @@ void LineMessenger::emit(const LineInfoTy* li) {
 }
 
 const LineInfoTy* LineMessenger::intern(const LineInfoTy& li) {
+  std::lock_guard<std::mutex> lock(mutex);
   return internTable.intern(li);
 }
 
 void LineMessenger::clear() {
   if (!UNIQUE_MSG) {
-    outs() << " ---- restarting checking for function " << funName(lastFunction) << " (previous messages for it to be ignored) ----\n";
+    *out << " ---- restarting checking for function " << funName(lastFunction) << " (previous messages for it to be ignored) ----\n";
   } else {
     lineBuffer.clear();
     // not clearing the intern table
@@ -148,7 +155,7 @@ void DelayedLineMessenger::flush() {
   delayedLineBuffer.clear();
 }
 
-void DelayedLineMessenger::print(const std::string& prefix) {
+void DelayedLineMessenger::print(const std::string& prefix) const {
   for(LineInfoPtrSetTy::const_iterator bi = delayedLineBuffer.begin(), be = delayedLineBuffer.end(); bi != be; ++bi) {
     const LineInfoTy *li = *bi;
     outs() << prefix;
@@ -5,7 +5,9 @@
 
 #include "table.h"
 
+#include <mutex>
 #include <set>
+#include <vector>
 
 #include <llvm/IR/Function.h>
 #include <llvm/IR/Instruction.h>
@@ -26,7 +28,8 @@ struct LineInfoTy {
     LineInfoTy(const std::string& kind, const std::string& message, const std::string& path, unsigned line): 
       kind(kind), message(message), path(path), line(line) {}
     
-    void print() const;
+    void print() const { print(outs()); }
+    void print(raw_ostream& out) const;
     bool operator==(const LineInfoTy& other) const {
       return kind == other.kind && message == other.message && path == other.path && line == other.line;
     }
@@ -46,6 +49,7 @@ struct LineInfoTy_equal {
 
 typedef std::set<const LineInfoTy*, LineInfoTyPtr_compare> LineInfoPtrSetTy; // for ordering messages, uniqueness
 typedef InterningTable<LineInfoTy, LineInfoTy_hash, LineInfoTy_equal> LineInfoTableTy; // for interning table (performance)
+typedef std::vector<const LineInfoTy*> LineInfoPtrVectorTy; // for recording messages
 
 class BaseLineMessenger {
 
@@ -85,15 +89,20 @@ class LineMessenger : public BaseLineMessenger {
   
   Function *lastFunction;
   std::string lastChecksName;
+  raw_ostream* out; // where messages are printed, outs() by default
+  std::mutex mutex; // messages may be emitted by multiple threads exploring the same function (bcheck)
+  static thread_local LineInfoPtrVectorTy* recorder; // when set, messages emitted by the current thread are also appended here (so that they can be replayed)
 //  const LLVMContext& context;
   
   public:
     LineMessenger(LLVMContext& context, bool _DEBUG, bool TRACE, bool UNIQUE_MSG):
-      BaseLineMessenger(_DEBUG, TRACE, UNIQUE_MSG), lineBuffer(), internTable(), lastFunction(NULL), lastChecksName() {};
+      BaseLineMessenger(_DEBUG, TRACE, UNIQUE_MSG), lineBuffer(), internTable(), lastFunction(NULL), lastChecksName(), out(&outs()), mutex() {};
 //      BaseLineMessenger(_DEBUG, TRACE, UNIQUE_MSG), lineBuffer(), internTable(), lastFunction(NULL), lastChecksName(), context(context)  {};
       
     void flush();
     void clear();
+    void setOutput(raw_ostream& out) { this->out = &out; }
+    void record(LineInfoPtrVectorTy* recorder) { LineMessenger::recorder = recorder; } // NULL stops recording
     void newFunction(Function *func, const std::string& checksName);
     void newFunction(Function *func) { newFunction(func, ""); }
     
@@ -125,7 +134,7 @@ struct DelayedLineMessenger : public BaseLineMessenger {
   bool operator==(const DelayedLineMessenger& other) const;
   virtual void emit(const LineInfoTy* li);
   size_t size() const { return delayedLineBuffer.size(); }
-  void print(const std::string& prefix);
+  void print(const std::string& prefix) const;
 };
 
 #endif
@@ -27,6 +27,7 @@
 
 #include "allocators.h"
 #include "cgclosure.h"
+#include "tools.h"
 
 using namespace llvm;
 
@@ -36,7 +37,7 @@ enum ArgExpKind {
   AK_FRESH         // allocation and possibly returning a fresh object
 };
 
-ArgExpKind classifyArgumentExpression(Value *arg, FunctionsInfoMapTy& functionsMap, unsigned gcFunctionIndex, FunctionsSetTy& possibleAllocators) {
+static ArgExpKind classifyArgumentExpression(Value *arg, FunctionsInfoMapTy& functionsMap, unsigned gcFunctionIndex, FunctionsSetTy& possibleAllocators) {
 
   if (!CallInst::classof(arg)) {
     // argument does not come (immediatelly) from a call
@@ -62,21 +63,11 @@ ArgExpKind classifyArgumentExpression(Value *arg, FunctionsInfoMapTy& functionsM
 }
 
 
-int main(int argc, char* argv[])
+static int runMaacheck(ModuleAnalysesTy& analyses, FunctionsOrderedSetTy& functionsOfInterestSet, FunctionsVectorTy& functionsOfInterestVector)
 {
-  LLVMContext context;
-  FunctionsOrderedSetTy functionsOfInterestSet;
-  FunctionsVectorTy functionsOfInterestVector;
-  
-  Module *m = parseArgsReadIR(argc, argv, functionsOfInterestSet, functionsOfInterestVector, context);  
-  
-  FunctionsInfoMapTy functionsMap;
-  buildCGClosure(m, functionsMap, true /* ignore error paths */);
-  
-  unsigned gcFunctionIndex = getGCFunctionIndex(functionsMap, m);
-  
-  FunctionsSetTy possibleAllocators;
-  findPossibleAllocators(m, possibleAllocators); // FIXME: use context-sensitive (more precise) detection
+  FunctionsInfoMapTy& functionsMap = *analyses.getCGClosure();
+  unsigned gcFunctionIndex = analyses.getGCFunctionIndex();
+  FunctionsSetTy& possibleAllocators = *analyses.getPossibleAllocators(); // FIXME: use context-sensitive (more precise) allocator detection
 
   for(FunctionsVectorTy::iterator FI = functionsOfInterestVector.begin(), FE = functionsOfInterestVector.end(); FI != FE; ++FI) {
 
@@ -129,6 +120,14 @@ int main(int argc, char* argv[])
       }
     }
   }
+  return 0;
+}
+
+const ToolTy maacheckTool = {"maacheck", NULL, runMaacheck, false, true};
 
-  delete m;
+#ifndef RCHK_DRIVER
+int main(int argc, char* argv[])
+{
+  return runTool(maacheckTool, argc, argv);
 }
+#endif
@@ -0,0 +1,195 @@
+/*
+  Runs several tools on the same module in a single process.
+
+    rchk --tools tool1,tool2,... [--outputs stem] [options] base_file.bc [module_file.bc]
+
+  The module is read (and linked) once and the module-wide analyses (see
+  analyses.h) are computed at most once and shared by the tools.  The options
+  are those of the selected tools and those of all tools (see common.cpp).
+
+  The tools run in the order of allTools below, regardless of the order in
+  which they are given: bcheck runs last, because it adds contexts to the
+  shared called module, which would change the output of the tools listing
+  called functions.
+
+  Without --outputs, the output of each tool is preceded by a line with its
+  name.  With --outputs, the output (standard and error) of each tool goes to
+  file stem.tool, so e.g. with stem libs/png.so, the output of bcheck goes to
+  libs/png.so.bcheck, as with scripts/check_package.sh.
+
+  The exit status is that of the first tool that failed.
+*/
+
+#include "common.h"
+#include "analyses.h"
+#include "lazy.h"
+#include "tools.h"
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/Module.h>
+
+#include <llvm/Support/raw_ostream.h>
+
+using namespace llvm;
+
+static const ToolTy* const allTools[] = {
+  &errcheckTool, &symcheckTool, &glcheckTool, &sfpcheckTool, &maacheckTool, &ueacheckTool, &cgcheckTool,
+  &csfpcheckTool, &alloccheckTool, &veccheckTool, &fficheckTool, &bcheckTool
+};
+const unsigned nTools = sizeof(allTools) / sizeof(allTools[0]);
+
+typedef std::vector<const ToolTy*> ToolsVectorTy;
+
+static bool selectTools(const std::string& names, ToolsVectorTy& tools) {
+
+  std::vector<std::string> selected;
+  size_t start = 0;
+  for(;;) {
+    size_t end = names.find(',', start);
+    std::string name = names.substr(start, end == std::string::npos ? std::string::npos : end - start);
+
+    bool known = false;
+    for(unsigned i = 0; i < nTools; i++) {
+      if (name == allTools[i]->name) {
+        known = true;
+        break;
+      }
+    }
+    if (!known) {
+      errs() << "Unknown tool: " << name << "\n";
+      return false;
+    }
+    selected.push_back(name);
+    if (end == std::string::npos) {
+      break;
+    }
+    start = end + 1;
+  }
+
+  for(unsigned i = 0; i < nTools; i++) {
+    for(std::vector<std::string>::iterator ni = selected.begin(), ne = selected.end(); ni != ne; ++ni) {
+      if (*ni == allTools[i]->name) {
+        tools.push_back(allTools[i]);
+        break;
+      }
+    }
+  }
+  return true;
+}
+
+// redirects both standard and error output to the file, saving the original ones
+static bool redirectOutput(const std::string& fname, int& savedOut, int& savedErr) {
+
+  outs().flush();
+  errs().flush();
+
+  int fd = open(fname.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+  if (fd == -1) {
+    errs() << "ERROR: Cannot write output file " << fname << "\n";
+    return false;
+  }
+  savedOut = dup(1);
+  savedErr = dup(2);
+  dup2(fd, 1);
+  dup2(fd, 2);
+  close(fd);
+  return true;
+}
+
+static void restoreOutput(int savedOut, int savedErr) {
+
+  outs().flush();
+  errs().flush();
+
+  dup2(savedOut, 1);
+  dup2(savedErr, 2);
+  close(savedOut);
+  close(savedErr);
+}
+
+int main(int argc, char* argv[])
+{
+  std::string toolsArg;
+  std::string outputsStem;
+  ToolsVectorTy tools;
+
+  if (!extractOption(argc, argv, "tools", toolsArg) || !selectTools(toolsArg, tools) ||
+      (extractOption(argc, argv, "outputs", outputsStem) && outputsStem.empty())) {
+    errs() << argv[0] << " --tools tool1,tool2,... [--outputs stem] [options] base_file.bc [module_file.bc]\n";
+    errs() << "  tools:";
+    for(unsigned i = 0; i < nTools; i++) {
+      errs() << " " << allTools[i]->name;
+    }
+    errs() << "\n";
+    return 1;
+  }
+
+  if (!outputsStem.empty()) {
+    for(int i = 1; i < argc; i++) {
+      if (!strncmp(argv[i], "--batch", 7) || !strncmp(argv[i], "--server", 8)) {
+        errs() << "Option --outputs cannot be used with --batch and --server (the output file is given for each module)\n";
+        return 1;
+      }
+    }
+  }
+
+  for(ToolsVectorTy::iterator ti = tools.begin(), te = tools.end(); ti != te; ++ti) {
+    const ToolTy* tool = *ti;
+    if (tool->extractOptions && !tool->extractOptions(argc, argv)) {
+      return 1;
+    }
+  }
+
+  LLVMContext context;
+  FunctionsOrderedSetTy functionsOfInterestSet;
+  FunctionsVectorTy functionsOfInterestVector;
+  Module *m = parseArgsReadIR(argc, argv, functionsOfInterestSet, functionsOfInterestVector, context);
+  for(ToolsVectorTy::iterator ti = tools.begin(), te = tools.end(); ti != te; ++ti) {
+    if ((*ti)->allFunctions) {
+      materializeModule(m); // before any of the shared analyses is computed
+      break;
+    }
+  }
+
+  int res = 0;
+  {
+    ModuleAnalysesTy analyses(m);
+
+    for(ToolsVectorTy::iterator ti = tools.begin(), te = tools.end(); ti != te; ++ti) {
+      const ToolTy* tool = *ti;
+      int savedOut, savedErr;
+
+      if (!outputsStem.empty()) {
+        if (!redirectOutput(outputsStem + "." + tool->name, savedOut, savedErr)) {
+          if (!res) {
+            res = 1;
+          }
+          continue;
+        }
+      } else {
+        outs() << "=== " << tool->name << "\n";
+      }
+
+      int tres = runToolOnShard(*tool, analyses, functionsOfInterestSet, functionsOfInterestVector);
+      if (tres && !res) {
+        res = tres;
+      }
+
+      if (!outputsStem.empty()) {
+        restoreOutput(savedOut, savedErr);
+      } else {
+        outs().flush();
+        errs().flush();
+      }
+    }
+  }
+  delete m;
+  return res;
+}
@@ -0,0 +1,93 @@
+/*
+  Sends a request to check a module to a tool running as a server (see server.h)
+  and waits for the check to finish.
+
+    rchkclient socket module.bc output_file
+
+  The exit status is 0 when the module has been checked, 1 when the check
+  failed and 2 when the server could not be reached.
+*/
+
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+static std::string absolutePath(const std::string& path) {
+
+  if (!path.empty() && path[0] == '/') {
+    return path;
+  }
+  char cwd[PATH_MAX];
+  if (!getcwd(cwd, sizeof(cwd))) {
+    return path;
+  }
+  return std::string(cwd) + "/" + path;
+}
+
+int main(int argc, char* argv[])
+{
+  if (argc != 4) {
+    std::cerr << argv[0] << " socket module_file.bc output_file\n";
+    return 2;
+  }
+  std::string path = argv[1];
+  std::string request = absolutePath(argv[2]) + " " + absolutePath(argv[3]) + "\n";
+
+  struct sockaddr_un addr;
+  if (path.size() >= sizeof(addr.sun_path)) {
+    std::cerr << "ERROR: Server socket path too long: " << path << "\n";
+    return 2;
+  }
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd == -1 || connect(fd, (struct sockaddr *) &addr, sizeof(addr)) == -1) {
+    std::cerr << "ERROR: Cannot connect to server " << path << ": " << strerror(errno) << "\n";
+    return 2;
+  }
+
+  size_t sent = 0;
+  while(sent < request.size()) {
+    ssize_t n = send(fd, request.data() + sent, request.size() - sent, MSG_NOSIGNAL);
+    if (n == -1 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      std::cerr << "ERROR: Cannot send request to server " << path << "\n";
+      return 2;
+    }
+    sent += n;
+  }
+
+  std::string reply;
+  char c;
+  for(;;) {
+    ssize_t n = read(fd, &c, 1);
+    if (n == -1 && errno == EINTR) {
+      continue;
+    }
+    if (n != 1 || c == '\n') {
+      break;
+    }
+    reply += c;
+  }
+  close(fd);
+
+  if (reply == "OK") {
+    return 0;
+  }
+  if (reply.empty()) {
+    std::cerr << "ERROR: No reply from server " << path << "\n";
+    return 2;
+  }
+  std::cerr << "ERROR: " << reply << "\n";
+  return 1;
+}
@@ -0,0 +1,233 @@
+/*
+  Merges the outputs of the parts of a sharded run (--shard, see shard.h)
+  into the output of a single run.
+
+    rchkmerge part1_output part2_output ... partN_output
+
+  The outputs are given in the order of the parts and the merged output is
+  written to standard output.  An output may be that of a single tool or of
+  the rchk driver (without --outputs), in which case the output of each tool
+  is merged separately.
+
+  The output of a tool in a part consists of the messages of the analyses of
+  the whole module (the same lines at the start of all parts), of the messages
+  for the functions of the part (in the order of the functions) and of a
+  summary (bcheck).  The merged output has the messages of the analyses once,
+  then the messages for the functions of all parts and then a summary with the
+  numbers of functions and states added up (the number of pending states is
+  the maximum over the parts, so it may differ from that of a single run).
+
+  The exit status is 0 on success and 1 when the outputs cannot be read or do
+  not come from the same run.
+*/
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+typedef std::vector<std::string> LinesTy;
+
+struct SectionTy {
+  std::string header; // "=== tool" from the rchk driver, empty for a single tool
+  LinesTy lines;
+};
+
+typedef std::vector<SectionTy> SectionsTy;
+
+static bool isToolHeader(const std::string& line) {
+  return line.compare(0, 4, "=== ") == 0;
+}
+
+static bool readSections(const std::string& fname, SectionsTy& sections) {
+
+  std::ifstream in(fname);
+  if (!in) {
+    std::cerr << "ERROR: Cannot read output " << fname << "\n";
+    return false;
+  }
+  std::string line;
+  while(std::getline(in, line)) {
+    if (isToolHeader(line)) {
+      SectionTy s;
+      s.header = line;
+      sections.push_back(s);
+      continue;
+    }
+    if (sections.empty()) {
+      sections.push_back(SectionTy());
+    }
+    sections.back().lines.push_back(line);
+  }
+  return true;
+}
+
+// the summary of bcheck, e.g.
+//   Analyzed 212 functions, traversed 257042 states (rpo worklist, at most 17 pending).
+
+struct SummaryTy {
+  unsigned long nFunctions;
+  unsigned long nStates;
+  std::string rest; // from after the number of states
+};
+
+static bool parseSummary(const std::string& line, SummaryTy& summary) {
+
+  int restStart = -1;
+  if (sscanf(line.c_str(), "Analyzed %lu functions, traversed %lu states%n", &summary.nFunctions, &summary.nStates, &restStart) < 2 ||
+      restStart < 0) {
+    return false;
+  }
+  summary.rest = line.substr(restStart);
+  return true;
+}
+
+static const char* const PENDING_PREFIX = "at most ";
+
+static unsigned long pendingStates(const std::string& rest) {
+
+  size_t pos = rest.find(PENDING_PREFIX);
+  if (pos == std::string::npos) {
+    return 0;
+  }
+  return strtoul(rest.c_str() + pos + strlen(PENDING_PREFIX), NULL, 10);
+}
+
+static std::string withPendingStates(const std::string& rest, unsigned long pending) {
+
+  size_t pos = rest.find(PENDING_PREFIX);
+  if (pos == std::string::npos) {
+    return rest;
+  }
+  pos += strlen(PENDING_PREFIX);
+  size_t end = rest.find_first_not_of("0123456789", pos);
+  return rest.substr(0, pos) + std::to_string(pending) + rest.substr(end == std::string::npos ? rest.size() : end);
+}
+
+// merges the outputs of a tool in the parts
+static void mergeSection(const std::vector<const LinesTy*>& parts, LinesTy& merged) {
+
+  // tools that are not split produce output only in part 1
+  std::vector<const LinesTy*> nonEmpty;
+  for(std::vector<const LinesTy*>::const_iterator pi = parts.begin(), pe = parts.end(); pi != pe; ++pi) {
+    if (!(*pi)->empty()) {
+      nonEmpty.push_back(*pi);
+    }
+  }
+  if (nonEmpty.empty()) {
+    return;
+  }
+
+  // the summary, when all parts have one
+  bool haveSummary = true;
+  SummaryTy total;
+  total.nFunctions = 0;
+  total.nStates = 0;
+  unsigned long pending = 0;
+  for(std::vector<const LinesTy*>::const_iterator pi = nonEmpty.begin(), pe = nonEmpty.end(); pi != pe; ++pi) {
+    SummaryTy s;
+    if (!parseSummary((*pi)->back(), s)) {
+      haveSummary = false;
+      break;
+    }
+    if (pi == nonEmpty.begin()) {
+      total.rest = s.rest;
+    }
+    total.nFunctions += s.nFunctions;
+    total.nStates += s.nStates;
+    unsigned long p = pendingStates(s.rest);
+    if (p > pending) {
+      pending = p;
+    }
+  }
+  size_t summaryLines = haveSummary ? 1 : 0;
+
+  // the messages of the analyses of the whole module, common to all parts
+  //   (an empty line starts the messages for a function in bcheck)
+  const LinesTy& first = *nonEmpty.front();
+  size_t prefix = 0;
+  for(;;) {
+    bool common = true;
+    for(std::vector<const LinesTy*>::const_iterator pi = nonEmpty.begin(), pe = nonEmpty.end(); pi != pe; ++pi) {
+      const LinesTy& lines = **pi;
+      if (prefix + summaryLines >= lines.size() || lines[prefix].empty() || lines[prefix] != first[prefix]) {
+        common = false;
+        break;
+      }
+    }
+    if (!common) {
+      break;
+    }
+    prefix++;
+  }
+
+  merged.insert(merged.end(), first.begin(), first.begin() + prefix);
+  for(std::vector<const LinesTy*>::const_iterator pi = nonEmpty.begin(), pe = nonEmpty.end(); pi != pe; ++pi) {
+    const LinesTy& lines = **pi;
+    merged.insert(merged.end(), lines.begin() + prefix, lines.end() - summaryLines);
+  }
+  if (haveSummary) {
+    merged.push_back("Analyzed " + std::to_string(total.nFunctions) + " functions, traversed " + std::to_string(total.nStates) +
+      " states" + withPendingStates(total.rest, pending));
+  }
+}
+
+int main(int argc, char* argv[])
+{
+  if (argc < 2) {
+    std::cerr << argv[0] << " part1_output [part2_output ...]\n";
+    return 1;
+  }
+
+  std::vector<SectionsTy> outputs(argc - 1);
+  for(int i = 1; i < argc; i++) {
+    if (!readSections(argv[i], outputs[i - 1])) {
+      return 1;
+    }
+  }
+
+  // with the driver, all parts have the output of the same tools
+  SectionsTy& first = outputs.front();
+  for(int i = 1; i < argc; i++) {
+    SectionsTy& sections = outputs[i - 1];
+    bool same = sections.size() == first.size();
+    for(unsigned j = 0; same && j < sections.size(); j++) {
+      same = sections[j].header == first[j].header;
+    }
+    if (!same && !(sections.empty() || first.empty())) {
+      std::cerr << "ERROR: Output " << argv[i] << " is not from the same tools as " << argv[1] << "\n";
+      return 1;
+    }
+  }
+
+  unsigned nSections = 0;
+  for(int i = 1; i < argc; i++) {
+    if (outputs[i - 1].size() > nSections) {
+      nSections = outputs[i - 1].size();
+    }
+  }
+
+  for(unsigned j = 0; j < nSections; j++) {
+    std::vector<const LinesTy*> parts;
+    std::string header;
+    for(int i = 1; i < argc; i++) {
+      SectionsTy& sections = outputs[i - 1];
+      if (j < sections.size()) { // empty outputs have no sections
+        parts.push_back(&sections[j].lines);
+        header = sections[j].header;
+      }
+    }
+    if (!header.empty()) {
+      std::cout << header << "\n";
+    }
+    LinesTy merged;
+    mergeSection(parts, merged);
+    for(LinesTy::const_iterator li = merged.begin(), le = merged.end(); li != le; ++li) {
+      std::cout << *li << "\n";
+    }
+  }
+  return 0;
+}
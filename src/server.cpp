@@ -0,0 +1,219 @@
+
+#include "server.h"
+#include "batch.h"
+#include "cache.h"
+#include "common.h"
+
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <sstream>
+
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <llvm/Support/raw_ostream.h>
+
+using namespace llvm;
+
+ServerOptionsTy serverOptions;
+
+const size_t MAX_REQUEST_SIZE = 65536;
+
+bool extractServerOptions(int& argc, char* argv[]) {
+
+  std::string arg;
+  if (extractOption(argc, argv, "server", serverOptions.socketFname) && serverOptions.socketFname.empty()) {
+    errs() << "Invalid server socket\n";
+    return false;
+  }
+  if (extractOption(argc, argv, "server-jobs", arg) && (!parseUnsigned(arg, serverOptions.jobs) || serverOptions.jobs == 0)) {
+    errs() << "Invalid number of server jobs: " << arg << "\n";
+    return false;
+  }
+  return true;
+}
+
+static volatile sig_atomic_t stopRequested = 0;
+
+static void requestStop(int) {
+  stopRequested = 1;
+}
+
+static void setStopHandlers(bool enable) {
+
+  struct sigaction sa;
+  sa.sa_handler = enable ? requestStop : SIG_DFL;
+  sigemptyset(&sa.sa_mask);
+  sa.sa_flags = 0; // no SA_RESTART, so that accept is interrupted
+  sigaction(SIGTERM, &sa, NULL);
+  sigaction(SIGINT, &sa, NULL);
+}
+
+static bool readRequest(int fd, std::string& request) {
+
+  char c;
+  while(request.size() < MAX_REQUEST_SIZE) {
+    ssize_t n = read(fd, &c, 1);
+    if (n == -1 && errno == EINTR) {
+      continue;
+    }
+    if (n != 1) {
+      return false;
+    }
+    if (c == '\n') {
+      return true;
+    }
+    request += c;
+  }
+  return false;
+}
+
+static void sendReply(int fd, const std::string& reply) {
+
+  std::string line = reply + "\n";
+  size_t sent = 0;
+  while(sent < line.size()) {
+    ssize_t n = send(fd, line.data() + sent, line.size() - sent, MSG_NOSIGNAL);
+    if (n == -1 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      return; // the client is gone
+    }
+    sent += n;
+  }
+}
+
+// runs in a forked process for each connection
+//   returns only in the process checking the module
+
+static void handleRequest(int fd, std::string& moduleFname) {
+
+  std::string request;
+  if (!readRequest(fd, request)) {
+    sendReply(fd, "FAILED cannot read request");
+    exit(0);
+  }
+  std::istringstream rs(request);
+  std::string module, output, rest;
+  if (!(rs >> module >> output) || (rs >> rest)) {
+    sendReply(fd, "FAILED invalid request (expected module and output file)");
+    exit(0);
+  }
+  if (module[0] != '/' || output[0] != '/') {
+    // the server runs in a directory unrelated to that of the client
+    sendReply(fd, "FAILED invalid request (paths must be absolute)");
+    exit(0);
+  }
+
+  pid_t pid = forkForModule(output);
+  if (pid == -1) {
+    sendReply(fd, "FAILED cannot fork");
+    exit(0);
+  }
+  if (pid == 0) {
+    close(fd);
+    moduleFname = module;
+    return;
+  }
+
+  int status;
+  while(waitpid(pid, &status, 0) == -1) {
+    if (errno != EINTR) {
+      sendReply(fd, "FAILED cannot wait for the check");
+      exit(0);
+    }
+  }
+  if (WIFSIGNALED(status)) {
+    sendReply(fd, "FAILED signal " + std::to_string(WTERMSIG(status)) + ", see " + output);
+  } else if (WEXITSTATUS(status) != 0) {
+    sendReply(fd, "FAILED exit status " + std::to_string(WEXITSTATUS(status)) + ", see " + output);
+  } else {
+    sendReply(fd, "OK");
+  }
+  exit(0);
+}
+
+void runServer(Module *base, const std::string& baseFname, std::string& moduleFname) {
+
+  const std::string& path = serverOptions.socketFname;
+  struct sockaddr_un addr;
+  if (path.size() >= sizeof(addr.sun_path)) {
+    errs() << "ERROR: Server socket path too long: " << path << "\n";
+    exit(1);
+  }
+
+  int lfd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (lfd == -1) {
+    errs() << "ERROR: Cannot create server socket\n";
+    exit(1);
+  }
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+  struct stat st;
+  if (lstat(path.c_str(), &st) == 0) {
+    if (!S_ISSOCK(st.st_mode)) {
+      errs() << "ERROR: Server socket path exists and is not a socket: " << path << "\n";
+      exit(1);
+    }
+    unlink(path.c_str()); // left over by a previous server
+  }
+  mode_t oldMask = umask(0177); // mode 0600, only the user can connect, as requests write files as the server
+  int res = bind(lfd, (struct sockaddr *) &addr, sizeof(addr));
+  umask(oldMask);
+  if (res == -1 || listen(lfd, SOMAXCONN) == -1) {
+    errs() << "ERROR: Cannot listen on server socket " << path << "\n";
+    exit(1);
+  }
+
+  std::string tmpCacheDir = useTemporaryCache(base, baseFname);
+  setStopHandlers(true);
+  errs() << "Listening on " << path << "\n";
+
+  unsigned long nRunning = 0;
+  while(!stopRequested) {
+    while(nRunning > 0 && waitpid(-1, NULL, WNOHANG) > 0) {
+      nRunning--;
+    }
+    if (nRunning >= serverOptions.jobs) {
+      if (waitpid(-1, NULL, 0) > 0) {
+        nRunning--;
+      }
+      continue;
+    }
+
+    int fd = accept(lfd, NULL, NULL);
+    if (fd == -1) {
+      continue; // interrupted
+    }
+    analysesCache.reload(); // keep analyses stored by previous checks in memory
+
+    pid_t pid = forkForModule("/dev/null"); // the handler has no output of its own
+    if (pid == 0) {
+      setStopHandlers(false);
+      close(lfd);
+      handleRequest(fd, moduleFname);
+      return;
+    }
+    close(fd);
+    if (pid == -1) {
+      errs() << "ERROR: Cannot fork to handle a request\n";
+      continue;
+    }
+    nRunning++;
+  }
+
+  close(lfd);
+  unlink(path.c_str());
+  while(nRunning > 0 && waitpid(-1, NULL, 0) > 0) {
+    nRunning--;
+  }
+  removeTemporaryCache(tmpCacheDir);
+  errs() << "Server stopped\n";
+  exit(0);
+}
@@ -0,0 +1,47 @@
+#ifndef RCHK_SERVER_H
+#define RCHK_SERVER_H
+
+#include <string>
+
+#include <llvm/IR/Module.h>
+
+using namespace llvm;
+
+// resident server checking modules against a base module kept in memory
+//   it is enabled using command line options of all tools (but fficheck)
+//     --server SOCKET     path of the Unix domain socket to listen on
+//     --server-jobs N     modules checked at the same time (default 1)
+//
+//   a request is a single line with a module and the file for its output
+//   (absolute paths, as in the batch file, see batch.h); the reply, sent when
+//   the check has finished, is a single line
+//     OK
+//     FAILED reason
+//
+//   each request is handled in a forked process, which checks the module in a
+//   forked process of its own like in batch mode; the analyses of the base
+//   stored in the analyses cache (see cache.h) by earlier checks are kept in
+//   the memory of the server and inherited by the checks
+//
+//   the socket is created accessible only to the user running the server,
+//   and requests with relative paths are rejected
+//
+//   the server runs until it gets SIGTERM or SIGINT; rchkclient sends the
+//   requests
+
+struct ServerOptionsTy {
+  std::string socketFname; // empty means no server
+  unsigned long jobs;
+
+  ServerOptionsTy(): socketFname(), jobs(1) {};
+  bool enabled() const { return !socketFname.empty(); }
+};
+
+extern ServerOptionsTy serverOptions;
+
+bool extractServerOptions(int& argc, char* argv[]); // false on invalid options
+
+// returns only in the forked process checking a module, with moduleFname set
+void runServer(Module *base, const std::string& baseFname, std::string& moduleFname);
+
+#endif
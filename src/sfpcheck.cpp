@@ -21,21 +21,14 @@
 #include "cgclosure.h"
 #include "exceptions.h"
 #include "lannotate.h"
+#include "tools.h"
 
 using namespace llvm;
 
-int main(int argc, char* argv[])
+static int runSfpcheck(ModuleAnalysesTy& analyses, FunctionsOrderedSetTy& functionsOfInterestSet, FunctionsVectorTy& functionsOfInterestVector)
 {
-  LLVMContext context;
-  FunctionsOrderedSetTy functionsOfInterestSet;
-  FunctionsVectorTy functionsOfInterestVector;
-  
-  Module *m = parseArgsReadIR(argc, argv, functionsOfInterestSet, functionsOfInterestVector, context);
-  
-  FunctionsInfoMapTy functionsMap;
-  buildCGClosure(m, functionsMap, true /* ignore error paths */);
-  
-  unsigned gcFunctionIndex = getGCFunctionIndex(functionsMap, m);
+  FunctionsInfoMapTy& functionsMap = *analyses.getCGClosure();
+  unsigned gcFunctionIndex = analyses.getGCFunctionIndex();
   
   errs() << "List of functions and callsites calling (recursively) into " << gcFunction << ":\n";
 
@@ -64,5 +57,14 @@ int main(int argc, char* argv[])
     }
   }
   printLineAnnotations(sfpLines);
-  delete m;
+  return 0;
+}
+
+const ToolTy sfpcheckTool = {"sfpcheck", NULL, runSfpcheck, false, false};
+
+#ifndef RCHK_DRIVER
+int main(int argc, char* argv[])
+{
+  return runTool(sfpcheckTool, argc, argv);
 }
+#endif
@@ -0,0 +1,64 @@
+
+#include "shard.h"
+
+#include <vector>
+
+#include <llvm/IR/Function.h>
+#include <llvm/Support/raw_ostream.h>
+
+using namespace llvm;
+
+ShardOptionsTy shardOptions;
+
+bool extractShardOptions(int& argc, char* argv[]) {
+
+  std::string arg;
+  if (!extractOption(argc, argv, "shard", arg)) {
+    return true;
+  }
+  size_t slash = arg.find('/');
+  if (slash == std::string::npos || !parseUnsigned(arg.substr(0, slash), shardOptions.index) ||
+      !parseUnsigned(arg.substr(slash + 1), shardOptions.count) ||
+      shardOptions.index == 0 || shardOptions.index > shardOptions.count) {
+
+    errs() << "Invalid shard (expected I/N with I from 1 to N): " << arg << "\n";
+    return false;
+  }
+  return true;
+}
+
+// the estimated cost of checking a function
+static unsigned long functionCost(Function *fun) {
+
+  unsigned long cost = 1; // also for declarations, which are cheap but not free
+  for(Function::iterator bb = fun->begin(), bbe = fun->end(); bb != bbe; ++bb) {
+    cost += bb->size();
+  }
+  return cost;
+}
+
+void selectShard(const FunctionsVectorTy& functionsOfInterestVector, FunctionsOrderedSetTy& shardSet, FunctionsVectorTy& shardVector) {
+
+  std::vector<unsigned long> costs;
+  unsigned long totalCost = 0;
+  for(FunctionsVectorTy::const_iterator fi = functionsOfInterestVector.begin(), fe = functionsOfInterestVector.end(); fi != fe; ++fi) {
+    unsigned long cost = functionCost(*fi);
+    costs.push_back(cost);
+    totalCost += cost;
+  }
+
+  // a function belongs to the part in which the middle of its cost falls,
+  // counting the costs of the functions before it
+  unsigned long costBefore = 0;
+  for(unsigned i = 0, n = functionsOfInterestVector.size(); i < n; i++) {
+    unsigned long cost = costs.at(i);
+    unsigned long part = ((2 * costBefore + cost) * shardOptions.count) / (2 * totalCost);
+    costBefore += cost;
+
+    if (part + 1 == shardOptions.index) {
+      Function *fun = functionsOfInterestVector.at(i);
+      shardSet.insert(fun);
+      shardVector.push_back(fun);
+    }
+  }
+}
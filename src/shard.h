@@ -0,0 +1,34 @@
+#ifndef RCHK_SHARD_H
+#define RCHK_SHARD_H
+
+#include "common.h"
+
+// checking the functions of interest of a module in several processes
+//   it is enabled using command line option of all tools
+//     --shard I/N    check only part I of N (I from 1 to N)
+//
+//   the functions of interest, sorted by name (see sortFunctionsByName), are
+//   split into N consecutive parts of about the same estimated cost (the number
+//   of instructions), so the outputs of the parts, in order, can be merged into
+//   the output of a single run (see rchkmerge.cpp)
+//
+//   only tools checking the functions of interest one by one are split (see
+//   ToolTy in analyses.h); the other tools run in part 1 and do nothing in the
+//   other parts
+
+struct ShardOptionsTy {
+  unsigned long index; // from 1
+  unsigned long count; // 0 means no sharding
+
+  ShardOptionsTy(): index(0), count(0) {};
+  bool enabled() const { return count > 0; }
+};
+
+extern ShardOptionsTy shardOptions;
+
+bool extractShardOptions(int& argc, char* argv[]); // false on invalid options
+
+// the functions of the current part, in the order of functionsOfInterestVector
+void selectShard(const FunctionsVectorTy& functionsOfInterestVector, FunctionsOrderedSetTy& shardSet, FunctionsVectorTy& shardVector);
+
+#endif
@@ -0,0 +1,171 @@
+
+#include "spill.h"
+#include "common.h"
+#include "cow.h"
+
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <llvm/Support/raw_ostream.h>
+
+using namespace llvm;
+
+SpillOptionsTy spillOptions;
+
+bool extractSpillOptions(int& argc, char* argv[]) {
+
+  std::string arg;
+  extractOption(argc, argv, "spill-dir", spillOptions.dir);
+  if (extractOption(argc, argv, "spill-states", arg) && (!parseUnsigned(arg, spillOptions.maxInMemory) || spillOptions.maxInMemory == 0)) {
+    errs() << "Invalid number of states kept in memory: " << arg << "\n";
+    return false;
+  }
+  return true;
+}
+
+SpilledStatesTy::SpilledStatesTy(size_t recordSize):
+  recordSize(recordSize), slotSize(sizeof(uint64_t) + ((recordSize + sizeof(uint64_t) - 1) / sizeof(uint64_t)) * sizeof(uint64_t)),
+  capacity(0), count(0), slots(NULL), bloom(), spillAt(spillOptions.maxInMemory) {};
+
+SpilledStatesTy::~SpilledStatesTy() {
+  release();
+}
+
+void SpilledStatesTy::release() {
+  if (slots) {
+    munmap(slots, capacity * slotSize);
+    slots = NULL;
+  }
+}
+
+void SpilledStatesTy::clear() {
+  release();
+  capacity = 0;
+  count = 0;
+  std::vector<uint64_t>().swap(bloom);
+  spillAt = spillOptions.maxInMemory;
+}
+
+// the (zero-filled) file is unlinked right away, so that it is removed
+// also when the tool is killed
+void SpilledStatesTy::allocate(size_t newCapacity) {
+
+  std::string path = spillOptions.dir + "/rchk-spill-XXXXXX";
+  std::vector<char> pathBuf(path.begin(), path.end());
+  pathBuf.push_back(0);
+
+  int fd = mkstemp(pathBuf.data());
+  if (fd < 0) {
+    errs() << "ERROR: cannot create a file for spilled states in " << spillOptions.dir << "\n";
+    exit(1);
+  }
+  unlink(pathBuf.data());
+
+  size_t bytes = newCapacity * slotSize;
+  if (ftruncate(fd, bytes) != 0) {
+    errs() << "ERROR: cannot allocate " << bytes << " bytes for spilled states in " << spillOptions.dir << "\n";
+    exit(1);
+  }
+  void *mapped = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd); // the mapping keeps the file
+  if (mapped == MAP_FAILED) {
+    errs() << "ERROR: cannot map the file for spilled states\n";
+    exit(1);
+  }
+
+  char *oldSlots = slots;
+  size_t oldCapacity = capacity;
+
+  slots = (char *) mapped;
+  capacity = newCapacity;
+  bloom.assign(capacity * BLOOM_BITS_PER_SLOT / 64, 0);
+
+  if (oldSlots) {
+    for(size_t i = 0; i < oldCapacity; i++) {
+      const char *slot = oldSlots + i * slotSize;
+      uint64_t tag;
+      memcpy(&tag, slot, sizeof(tag));
+      if (tag) {
+        insertIntoTable(tag, slot + sizeof(tag));
+      }
+    }
+    munmap(oldSlots, oldCapacity * slotSize);
+  }
+}
+
+static uint64_t spillTag(size_t hashcode) {
+  uint64_t tag = mix_hash(hashcode);
+  return tag ? tag : 1; // zero marks empty slots
+}
+
+void SpilledStatesTy::addToBloom(uint64_t tag) {
+  uint64_t nbits = bloom.size() * 64;
+  uint64_t h2 = (tag >> 32) | 1;
+  for(unsigned i = 0; i < BLOOM_HASHES; i++) {
+    uint64_t bit = (tag + i * h2) % nbits;
+    bloom[bit / 64] |= ((uint64_t) 1) << (bit % 64);
+  }
+}
+
+bool SpilledStatesTy::maybeInBloom(uint64_t tag) const {
+  uint64_t nbits = bloom.size() * 64;
+  uint64_t h2 = (tag >> 32) | 1;
+  for(unsigned i = 0; i < BLOOM_HASHES; i++) {
+    uint64_t bit = (tag + i * h2) % nbits;
+    if (!(bloom[bit / 64] & (((uint64_t) 1) << (bit % 64)))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void SpilledStatesTy::insertIntoTable(uint64_t tag, const void* record) {
+
+  size_t mask = capacity - 1;
+  for(size_t i = tag & mask;; i = (i + 1) & mask) {
+    char *slot = slots + i * slotSize;
+    uint64_t stag;
+    memcpy(&stag, slot, sizeof(stag));
+    if (!stag) {
+      memcpy(slot, &tag, sizeof(tag));
+      memcpy(slot + sizeof(tag), record, recordSize);
+      addToBloom(tag);
+      return;
+    }
+  }
+}
+
+bool SpilledStatesTy::contains(size_t hashcode, const void* record) const {
+
+  if (!count) {
+    return false;
+  }
+  uint64_t tag = spillTag(hashcode);
+  if (!maybeInBloom(tag)) {
+    return false;
+  }
+  size_t mask = capacity - 1;
+  for(size_t i = tag & mask;; i = (i + 1) & mask) {
+    const char *slot = slots + i * slotSize;
+    uint64_t stag;
+    memcpy(&stag, slot, sizeof(stag));
+    if (!stag) {
+      return false;
+    }
+    if (stag == tag && !memcmp(slot + sizeof(tag), record, recordSize)) {
+      return true;
+    }
+  }
+}
+
+void SpilledStatesTy::insert(size_t hashcode, const void* record) {
+
+  if (2 * (count + 1) > capacity) {
+    allocate(capacity ? 2 * capacity : INITIAL_CAPACITY);
+  }
+  insertIntoTable(spillTag(hashcode), record);
+  count++;
+}
@@ -0,0 +1,100 @@
+#ifndef RCHK_SPILL_H
+#define RCHK_SPILL_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+// states of a function spilled to disk (bcheck, callocators)
+//   when exploring a function needs more states than fit into memory, the explored
+//   states that are no longer in the worklist can be moved to an on-disk hash table
+//   it is enabled using command line options of all tools
+//     --spill-dir DIR      directory for the table files (removed right after being created)
+//     --spill-states N     states of a function kept in memory before spilling (default 1000000)
+//
+//   with spilling enabled, the default maximum number of states per function does not
+//   apply (only --max-states and --max-allocator-states, when given)
+//
+//   states are stored as records of fixed size, compared byte by byte (so their
+//   padding has to be cleared); the records refer to interned components of the
+//   states, which are kept in memory
+//
+//   only the states are spilled: the interned components (guards, fresh variables,
+//   protect stacks, messages, called functions) stay in memory until the function
+//   has been explored, and they cannot be evicted, because the records compare
+//   them by pointers; so memory is bounded by --spill-states states plus the
+//   distinct components, which are shared by many states, but still grow with
+//   them; --max-memory (see budget.h) still applies to the whole
+//
+//   the table is memory-mapped, so that the system pages it in and out as needed;
+//   a Bloom filter in memory answers most lookups of new states without touching
+//   the table
+
+struct SpillOptionsTy {
+  std::string dir;          // empty means no spilling
+  unsigned long maxInMemory; // states
+
+  SpillOptionsTy(): dir(), maxInMemory(1000000) {};
+  bool enabled() const { return !dir.empty(); }
+};
+
+extern SpillOptionsTy spillOptions;
+
+bool extractSpillOptions(int& argc, char* argv[]); // false on invalid options
+
+class SpilledStatesTy {
+
+  static const size_t INITIAL_CAPACITY = 1 << 16; // slots
+  static const unsigned BLOOM_BITS_PER_SLOT = 8;
+  static const unsigned BLOOM_HASHES = 4;
+
+  size_t recordSize;
+  size_t slotSize; // the (non-zero) hash followed by the record
+  size_t capacity; // power of two, at most half of the slots are used
+  size_t count;
+  char *slots; // mapped table file, NULL when empty
+  std::vector<uint64_t> bloom;
+  size_t spillAt; // when the done set gets larger, states are spilled
+
+  void allocate(size_t newCapacity);
+  void release();
+  void insertIntoTable(uint64_t tag, const void* record);
+  void addToBloom(uint64_t tag);
+  bool maybeInBloom(uint64_t tag) const;
+
+  public:
+    SpilledStatesTy(size_t recordSize);
+    ~SpilledStatesTy();
+
+    bool contains(size_t hashcode, const void* record) const;
+    void insert(size_t hashcode, const void* record); // the record must not be in the table yet
+    void clear();
+    size_t size() const { return count; }
+
+    bool shouldSpill(size_t inMemory) const { return spillOptions.enabled() && inMemory > spillAt; }
+
+    // moves the explored states (not in the worklist) from the done set to disk
+    //   the states have to have a hashcode, makeRecord(state, record) fills in the record
+    template <class Record, class DoneSet, class WorkList, class MakeRecord> void spill(DoneSet& doneSet, WorkList& workList, MakeRecord makeRecord) {
+
+      std::unordered_set<const typename DoneSet::value_type*> pending;
+      workList.getItems(pending);
+
+      for(typename DoneSet::iterator si = doneSet.begin(); si != doneSet.end();) {
+        if (pending.find(&*si) != pending.end()) {
+          ++si;
+          continue;
+        }
+        Record record;
+        makeRecord(*si, record);
+        insert(si->hashcode, &record);
+        si = doneSet.erase(si);
+      }
+      spillAt = std::max((size_t) spillOptions.maxInMemory, 2 * doneSet.size()); // in case most states are in the worklist
+    }
+};
+
+#endif
@@ -1,5 +1,7 @@
 
 #include "symbols.h"
+#include "cache.h"
+#include "lazy.h"
 
 using namespace llvm;
 
@@ -52,48 +54,143 @@ bool isInstallConstantCall(Value *inst, std::string& symbolName) {
   return true;   
 }
 
+// kinds of SEXP global variables
+enum SymbolKind {
+  SK_NO_WRITES = 0,
+  SK_SYMBOL, // all writes are of the same installed symbol
+  SK_NOT_SYMBOL
+};
+
+// which writes to classify
+enum WritesFilter {
+  WF_ALL = 0,
+  WF_BASE, // in functions of the base module (see cache.h)
+  WF_PACKAGE
+};
+
+// classifies a SEXP global variable by the writes to it (selected by filter),
+// starting with the given kind and symbol name; the error found, if any, is
+// returned in error (the caller reports it)
+//
+//   with the analyses cache, the writes of the base are classified first, so
+//   that the kinds and errors of base variables can be cached and reported
+//   in the same way when the cached results are used
+static void classifyWrites(GlobalVariable *gv, WritesFilter filter, unsigned long& kind, std::string& symbolName, std::string& error) {
+
+  for(Value::user_iterator ui = gv->user_begin(), ue = gv->user_end(); ui != ue; ++ui) {
+    User *u = *ui;
+    if (!StoreInst::classof(u)) {
+      continue;
+    }
+    StoreInst *store = cast<StoreInst>(u);
+    if (filter != WF_ALL && analysesCache.isBaseFunction(store->getParent()->getParent()) != (filter == WF_BASE)) {
+      continue;
+    }
+    Value *valueOp = store->getValueOperand();
+    std::string name;
+    if (isInstallConstantCall(valueOp, name)) {
+      if (kind == SK_NO_WRITES) {
+        symbolName = name;
+        kind = SK_SYMBOL;
+      } else {
+        if (symbolName != name) {
+          error = "ERROR: Multiple names for symbol " + gv->getName().str() + ": " + symbolName + " and " + name + "\n";
+          kind = SK_NOT_SYMBOL;
+          return;
+        }
+      }
+    } else {
+      if (kind == SK_SYMBOL) {
+        error = "ERROR: Invalid write to symbol " + gv->getName().str();
+        if (Instruction::classof(valueOp)) {
+          error += " at " + sourceLocation(cast<Instruction>(valueOp));
+        }
+        error += "\n";
+      }
+      kind = SK_NOT_SYMBOL;
+      return;
+    }
+  }
+}
+
+// the cached kinds of SEXP global variables of the base module, by name
+//   (as classified by the writes in base functions, with the error reported)
+
+struct CachedSymbolTy {
+  unsigned long kind;
+  std::string symbolName;
+  std::string error;
+};
+
+typedef std::unordered_map<std::string, CachedSymbolTy> CachedSymbolsTy;
+
+static bool getCachedSymbols(Module *m, CachedSymbolsTy& cachedSymbols) {
+
+  std::string payload;
+  if (!analysesCache.get(m, "symbols", payload)) {
+    return false;
+  }
+  CacheReaderTy reader(payload, m);
+  while(!reader.atEnd()) {
+    std::string name;
+    CachedSymbolTy cs;
+    if (!reader.get(name) || !reader.get(cs.kind) || !reader.get(cs.symbolName) || !reader.get(cs.error)) {
+      cachedSymbols.clear();
+      return false;
+    }
+    cachedSymbols.insert({name, cs});
+  }
+  return true;
+}
+
 void findSymbols(Module *m, SymbolsMapTy* symbolsMap) {
 
+  CachedSymbolsTy cachedSymbols;
+  bool cached = getCachedSymbols(m, cachedSymbols);
+  if (!cached) {
+    materializeModule(m);
+  }
+  CacheWriterTy writer;
+
   for(Module::global_iterator gi = m->global_begin(), ge = m->global_end(); gi != ge ; ++gi) {
     GlobalVariable *gv = &*gi;
     if (!isSEXP(gv)) {
       continue;
     }
-    bool foundInstall = false;
+    unsigned long kind = SK_NO_WRITES;
     std::string symbolName;
+    std::string error;
     
-    for(Value::user_iterator ui = gv->user_begin(), ue = gv->user_end(); ui != ue; ++ui) {
-      User *u = *ui;
-      if (!StoreInst::classof(u)) {
-        continue;
+    if (cached) {
+      // the writes in base functions have been classified already, but the package may write as well
+      auto csearch = cachedSymbols.find(gv->getName().str());
+      if (csearch != cachedSymbols.end()) {
+        kind = csearch->second.kind;
+        symbolName = csearch->second.symbolName;
+        error = csearch->second.error;
       }
-      Value *valueOp = cast<StoreInst>(u)->getValueOperand();
-      std::string name;
-      if (isInstallConstantCall(valueOp, name)) {
-        if (!foundInstall) {
-          symbolName = name;
-          foundInstall = true;
-        } else {
-          if (symbolName != name) {
-            errs() << "ERROR: Multiple names for symbol " << gv->getName() << ": " << symbolName << " and " << name << "\n";
-            goto cannot_be_symbol;
-          }
-        }
-      } else {
-        if (foundInstall) {
-          errs() << "ERROR: Invalid write to symbol " << gv->getName();
-          if (Instruction::classof(valueOp)) {
-            errs() << " at " << sourceLocation(cast<Instruction>(valueOp));
-          }
-          errs() << "\n";
-        }
-        goto cannot_be_symbol;
+      if (kind != SK_NOT_SYMBOL) {
+        classifyWrites(gv, WF_PACKAGE, kind, symbolName, error);
+      }
+    } else if (analysesCache.enabled(m) && analysesCache.isBaseGlobal(gv)) {
+      classifyWrites(gv, WF_BASE, kind, symbolName, error);
+      writer.put(gv->getName().str());
+      writer.put(kind);
+      writer.put(symbolName);
+      writer.put(error);
+      if (kind != SK_NOT_SYMBOL) {
+        classifyWrites(gv, WF_PACKAGE, kind, symbolName, error);
       }
+    } else {
+      classifyWrites(gv, WF_ALL, kind, symbolName, error);
     }
-    if (foundInstall) {
+    errs() << error;
+    
+    if (kind == SK_SYMBOL) {
       symbolsMap->insert({gv, symbolName});
     }
-    cannot_be_symbol:
-      ;    
   } 
+  if (!cached) {
+    analysesCache.put(m, "symbols", writer.str());
+  }
 }
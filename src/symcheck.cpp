@@ -17,20 +17,15 @@
 #include <llvm/Support/raw_ostream.h>
 
 #include "symbols.h"
+#include "tools.h"
 
 using namespace llvm;
 
-int main(int argc, char* argv[])
+static int runSymcheck(ModuleAnalysesTy& analyses, FunctionsOrderedSetTy& functionsOfInterestSet, FunctionsVectorTy& functionsOfInterestVector)
 {
-  LLVMContext context;
-  FunctionsOrderedSetTy functionsOfInterestSet;
-  FunctionsVectorTy functionsOfInterestVector;
-  
-  Module *m = parseArgsReadIR(argc, argv, functionsOfInterestSet, functionsOfInterestVector, context);
     // NOTE: functionsOfInterest ignored but (re-)analyzing the R core is necessary
   
-  SymbolsMapTy symbolsMap;
-  findSymbols(m, &symbolsMap);
+  SymbolsMapTy& symbolsMap = *analyses.getSymbolsMap();
   
   for(SymbolsMapTy::iterator si = symbolsMap.begin(), se = symbolsMap.end(); si != se; ++si) {
     GlobalVariable *gv = si->first;
@@ -43,5 +38,14 @@ int main(int argc, char* argv[])
   // FIXME: the output could be sorted
   // FIXME: there could also be more detailed checks for ambiguous symbols (but I've not seen such in practice)
   
-  delete m;
+  return 0;
+}
+
+const ToolTy symcheckTool = {"symcheck", NULL, runSymcheck, false, false};
+
+#ifndef RCHK_DRIVER
+int main(int argc, char* argv[])
+{
+  return runTool(symcheckTool, argc, argv);
 }
+#endif
@@ -1,6 +1,7 @@
 #ifndef RCHK_TABLE_H
 #define RCHK_TABLE_H
 
+#include <mutex>
 #include <unordered_set>
 #include <vector>
 
@@ -33,6 +34,30 @@ template <
     }
 };
 
+// interning table that can be used from multiple threads at the same time
+
+template <
+  class Member,
+  class Hash = std::hash<Member>,
+  class KeyEqual = std::equal_to<Member>
+  
+> class ConcurrentInterningTable {
+
+  InterningTable<Member, Hash, KeyEqual> table;
+  std::mutex mutex;
+  
+  public:
+    const Member* intern(const Member& m) {
+      std::lock_guard<std::mutex> lock(mutex);
+      return table.intern(m);
+    }
+    
+    void clear() {
+      std::lock_guard<std::mutex> lock(mutex);
+      table.clear();
+    }
+};
+
 template <
   class Member,
   class Hash = std::hash<Member>,
@@ -82,6 +107,47 @@ template <
     }
 };
 
+// indexed interning table that can be used from multiple threads at the same time
+//   interned members are never moved, so they can be used without locking
+
+template <
+  class Member,
+  class Hash = std::hash<Member>,
+  class KeyEqual = std::equal_to<Member>
+
+> class ConcurrentIndexedInterningTable {
+
+  typedef IndexedInterningTable<Member, Hash, KeyEqual> Table;
+  Table table;
+  std::mutex mutex;
+
+  public:
+    const Member* intern(const Member& m) {
+      std::lock_guard<std::mutex> lock(mutex);
+      return table.intern(m);
+    }
+
+    const Member* at(unsigned idx) {
+      std::lock_guard<std::mutex> lock(mutex);
+      return table.at(idx);
+    }
+
+    size_t size() {
+      std::lock_guard<std::mutex> lock(mutex);
+      return table.getIndex()->size();
+    }
+
+    void clear() {
+      std::lock_guard<std::mutex> lock(mutex);
+      table.clear();
+    }
+
+    // only safe when no other thread may be interning
+    const std::vector<const Member*>* getIndex() const {
+      return table.getIndex();
+    }
+};
+
 template <class Member> class IndexedTable {
 
   public:
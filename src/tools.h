@@ -0,0 +1,23 @@
+#ifndef RCHK_TOOLS_H
+#define RCHK_TOOLS_H
+
+#include "analyses.h"
+
+// the tools, each defined in its *check.cpp file
+//   a tool file also defines the main function of the tool, unless compiled
+//   with RCHK_DRIVER for the driver running several tools (rchk.cpp)
+
+extern const ToolTy errcheckTool;
+extern const ToolTy symcheckTool;
+extern const ToolTy glcheckTool;
+extern const ToolTy sfpcheckTool;
+extern const ToolTy maacheckTool;
+extern const ToolTy ueacheckTool;
+extern const ToolTy cgcheckTool;
+extern const ToolTy csfpcheckTool;
+extern const ToolTy alloccheckTool;
+extern const ToolTy veccheckTool;
+extern const ToolTy fficheckTool;
+extern const ToolTy bcheckTool;
+
+#endif
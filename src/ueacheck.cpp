@@ -24,6 +24,7 @@
 
 #include "allocators.h"
 #include "cgclosure.h"
+#include "tools.h"
 
 using namespace llvm;
 
@@ -136,7 +137,7 @@ enum ArgExpKind {
   AK_FRESH         // allocation and possibly returning a fresh object
 };
 
-ArgExpKind classifyArgumentExpression(Value *arg, FunctionsInfoMapTy& functionsMap, unsigned gcFunctionIndex, FunctionsSetTy& possibleAllocators) {
+static ArgExpKind classifyArgumentExpression(Value *arg, FunctionsInfoMapTy& functionsMap, unsigned gcFunctionIndex, FunctionsSetTy& possibleAllocators) {
 
   if (!CallInst::classof(arg)) {
     // argument does not come (immediatelly) from a call
@@ -192,21 +193,11 @@ bool isLoadOfUnprotectedObject(Value *arg, Instruction *callInst, FunctionsSetTy
   return false;
 }
 
-int main(int argc, char* argv[])
+static int runUeacheck(ModuleAnalysesTy& analyses, FunctionsOrderedSetTy& functionsOfInterestSet, FunctionsVectorTy& functionsOfInterestVector)
 {
-  LLVMContext context;
-  FunctionsOrderedSetTy functionsOfInterestSet;
-  FunctionsVectorTy functionsOfInterestVector;
-  
-  Module *m = parseArgsReadIR(argc, argv, functionsOfInterestSet, functionsOfInterestVector, context);  
-  
-  FunctionsInfoMapTy functionsMap;
-  buildCGClosure(m, functionsMap, true /* ignore error paths */);
-  
-  unsigned gcFunctionIndex = getGCFunctionIndex(functionsMap, m);
-
-  FunctionsSetTy possibleAllocators;
-  findPossibleAllocators(m, possibleAllocators); // FIXME: use context-sensitive (more precise) allocator detection
+  FunctionsInfoMapTy& functionsMap = *analyses.getCGClosure();
+  unsigned gcFunctionIndex = analyses.getGCFunctionIndex();
+  FunctionsSetTy& possibleAllocators = *analyses.getPossibleAllocators(); // FIXME: use context-sensitive (more precise) allocator detection
 
   DominatorTreeWrapperPass dtPass;
 
@@ -284,6 +275,14 @@ int main(int argc, char* argv[])
       }
     }
   }
-  
-  delete m;
+  return 0;
+}
+
+const ToolTy ueacheckTool = {"ueacheck", NULL, runUeacheck, false, true};
+
+#ifndef RCHK_DRIVER
+int main(int argc, char* argv[])
+{
+  return runTool(ueacheckTool, argc, argv);
 }
+#endif
@@ -13,21 +13,24 @@
 #include <llvm/Support/raw_ostream.h>
 
 #include "vectors.h"
+#include "tools.h"
 
 using namespace llvm;
 
-int main(int argc, char* argv[])
+static int runVeccheck(ModuleAnalysesTy& analyses, FunctionsOrderedSetTy& functionsOfInterestSet, FunctionsVectorTy& functionsOfInterestVector)
 {
-  LLVMContext context;
-  FunctionsOrderedSetTy functionsOfInterestSet;
-  FunctionsVectorTy functionsOfInterestVector;
-  
-  Module *m = parseArgsReadIR(argc, argv, functionsOfInterestSet, functionsOfInterestVector, context);
-  CalledModuleTy *cm = CalledModuleTy::create(m);
+  CalledModuleTy *cm = analyses.getCalledModule();
   
     // FIXME: this will not discover many call-sites (will not include many interesting contexts)
   printVectorReturningFunctions(cm);
+  return 0;
+}
 
-  CalledModuleTy::release(cm);
-  delete m;
+const ToolTy veccheckTool = {"veccheck", NULL, runVeccheck, true, false};
+
+#ifndef RCHK_DRIVER
+int main(int argc, char* argv[])
+{
+  return runTool(veccheckTool, argc, argv);
 }
+#endif
@@ -5,6 +5,7 @@
 #include "callocators.h"
 #include "exceptions.h"
 
+#include <mutex>
 #include <unordered_map>
 #include <vector>
 
@@ -220,8 +221,9 @@ struct VectorsFunctionState {
 
 struct VrfStateTy {
   FunctionTableTy functions;
+  std::recursive_mutex mutex; // functions are analyzed lazily, possibly from multiple checking threads
   
-  VrfStateTy() : functions() {};
+  VrfStateTy() : functions(), mutex() {};
 };
 
 struct VectorsBlockState {
@@ -373,6 +375,11 @@ static void analyzeFunctionInContext(VectorsFunctionState& fstate, unsigned cont
   Function *fun = fstate.fun;
   ArgsTy context = fstate.contextIndex.at(contextIdx);
 
+  if (fun->empty()) {
+    // a declaration, or a function not read from lazily loaded bitcode (see lazy.h)
+    return;
+  }
+
   unsigned nvars = fstate.varIndex.size();
   
   BlocksTy blocks;
@@ -575,7 +582,9 @@ void freeVrfState(VrfStateTy *vrfState) {
 
 bool isVectorReturningFunction(Function *fun, ArgsTy context, CalledModuleTy* cm) {
 
-  FunctionTableTy* functionsPtr = &(cm->getVrfState()->functions);
+  VrfStateTy* vrfState = cm->getVrfState();
+  std::lock_guard<std::recursive_mutex> lock(vrfState->mutex);
+  FunctionTableTy* functionsPtr = &(vrfState->functions);
   FunctionListTy workList;
   FunctionTableTy& functions = *functionsPtr;
 
@@ -0,0 +1,46 @@
+
+#include "worklist.h"
+
+#include <llvm/ADT/PostOrderIterator.h>
+#include <llvm/IR/CFG.h>
+#include <llvm/Support/raw_ostream.h>
+
+using namespace llvm;
+
+WorkListStrategy workListStrategy = WS_DFS;
+bool workListStrategyGiven = false;
+
+bool extractWorkListStrategy(int& argc, char* argv[]) {
+
+  std::string arg;
+  if (!extractOption(argc, argv, "worklist", arg)) {
+    return true;
+  }
+  if (arg == "dfs") {
+    workListStrategy = WS_DFS;
+  } else if (arg == "rpo") {
+    workListStrategy = WS_RPO;
+  } else {
+    errs() << "Invalid worklist strategy (dfs or rpo): " << arg << "\n";
+    return false;
+  }
+  workListStrategyGiven = true;
+  return true;
+}
+
+std::string workListStrategyName(WorkListStrategy strategy) {
+  switch(strategy) {
+    case WS_DFS: return "dfs";
+    case WS_RPO: return "rpo";
+  }
+  return "unknown";
+}
+
+void numberBasicBlocksInReversePostOrder(Function *fun, BasicBlockIndexTy& index) {
+
+  ReversePostOrderTraversal<Function*> rpot(fun);
+  unsigned i = 0;
+  for(ReversePostOrderTraversal<Function*>::rpo_iterator bi = rpot.begin(), be = rpot.end(); bi != be; ++bi) {
+    index.insert({*bi, i++});
+  }
+}
@@ -0,0 +1,133 @@
+#ifndef RCHK_WORKLIST_H
+#define RCHK_WORKLIST_H
+
+#include "common.h"
+
+#include <algorithm>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <llvm/IR/BasicBlock.h>
+#include <llvm/IR/Function.h>
+
+using namespace llvm;
+
+// order in which states of a function are explored (bcheck, callocators)
+//   it can be selected using command line option of all tools
+//     --worklist dfs    last added state first (the default)
+//     --worklist rpo    state at the basic block earliest in reverse post-order first,
+//                       of states at the same block the one reached via more blocks first
+//
+//   the set of states explored is the same, but the order matters when
+//   checking is restarted on the first error found, or when the exploration
+//   budget is exceeded
+
+enum WorkListStrategy {
+  WS_DFS = 0,
+  WS_RPO
+};
+
+extern WorkListStrategy workListStrategy;
+extern bool workListStrategyGiven; // by --worklist, even when the default
+
+bool extractWorkListStrategy(int& argc, char* argv[]); // false on invalid option
+std::string workListStrategyName(WorkListStrategy strategy);
+
+typedef std::unordered_map<const BasicBlock*, unsigned> BasicBlockIndexTy;
+void numberBasicBlocksInReversePostOrder(Function *fun, BasicBlockIndexTy& index);
+
+// a worklist of (pointers to) states, which have to have a field bb
+//   the depth of a state is one more than the depth of the state last popped
+
+template <class T> class StateWorkListTy {
+
+  struct EntryTy {
+    T item;
+    unsigned index; // of the basic block in reverse post-order
+    unsigned depth;
+    unsigned long seq; // for determinism
+  };
+
+  struct EntryTy_less { // lower priority
+    bool operator()(const EntryTy& lhs, const EntryTy& rhs) const {
+      if (lhs.index != rhs.index) {
+        return lhs.index > rhs.index;
+      }
+      if (lhs.depth != rhs.depth) {
+        return lhs.depth < rhs.depth;
+      }
+      return lhs.seq < rhs.seq;
+    }
+  };
+
+  WorkListStrategy strategy;
+  std::vector<EntryTy> entries; // a stack (dfs) or a heap (rpo)
+  Function *fun;
+  BasicBlockIndexTy rpoIndex; // of fun
+  unsigned poppedDepth;
+  unsigned long nPushed;
+  size_t maxSize;
+
+  public:
+    StateWorkListTy(): strategy(WS_DFS), entries(), fun(NULL), rpoIndex(), poppedDepth(0), nPushed(0), maxSize(0) {};
+
+    // to be called before exploring states of a function
+    void start(Function *f) {
+      clear();
+      strategy = workListStrategy;
+      if (strategy == WS_RPO && fun != f) {
+        rpoIndex.clear();
+        numberBasicBlocksInReversePostOrder(f, rpoIndex);
+      }
+      fun = f;
+    }
+
+    void clear() {
+      std::vector<EntryTy>().swap(entries);
+      poppedDepth = 0;
+    }
+
+    void push(T item) {
+      EntryTy e = { item, 0, poppedDepth + 1, nPushed++ };
+      if (strategy == WS_DFS) {
+        entries.push_back(e);
+      } else {
+        auto isearch = rpoIndex.find(item->bb);
+        if (isearch != rpoIndex.end()) {
+          e.index = isearch->second;
+        }
+        entries.push_back(e);
+        std::push_heap(entries.begin(), entries.end(), EntryTy_less());
+      }
+      if (entries.size() > maxSize) {
+        maxSize = entries.size();
+      }
+    }
+
+    T top() const { return strategy == WS_DFS ? entries.back().item : entries.front().item; }
+
+    void pop() {
+      if (strategy == WS_DFS) {
+        poppedDepth = entries.back().depth;
+        entries.pop_back();
+      } else {
+        poppedDepth = entries.front().depth;
+        std::pop_heap(entries.begin(), entries.end(), EntryTy_less());
+        entries.pop_back();
+      }
+    }
+
+    void getItems(std::unordered_set<T>& items) const { // e.g. so that these states are not spilled
+      for(typename std::vector<EntryTy>::const_iterator ei = entries.begin(), ee = entries.end(); ei != ee; ++ei) {
+        items.insert(ei->item);
+      }
+    }
+
+    bool empty() const { return entries.empty(); }
+    size_t size() const { return entries.size(); }
+    size_t peakSize() const { return maxSize; } // largest size since created
+};
+
+#endif